@@ -0,0 +1,85 @@
+#include "Battery.h"
+
+/// @brief Creates a battery monitor.
+/// @param Config A reference to the shared configuration object.
+/// @param Telem A reference to the shared telemetry object.
+Battery::Battery(Configuration* Config, Telemetry* Telem)
+{
+    config = Config;
+    telemetry = Telem;
+}
+
+/// @brief Starts sampling the battery voltage. Call after the settings are loaded, changes to the pin or divider take effect on restart.
+void Battery::begin()
+{
+    pin = config->TunableBotSettings["batteryPin"].value;
+    divider = config->TunableBotSettings["batteryDivider"].value;
+    if (pin <= 0)
+    {
+        Serial.println("Battery voltage not measured");
+        return;
+    }
+    xTaskCreate(Battery::BatteryTaskWrapper, "Battery Monitor", 2048, this, 1, NULL);
+}
+
+/// @brief Gets the filtered battery voltage.
+/// @return The voltage in volts, 0 if not measured.
+float Battery::getVoltage()
+{
+    return voltage;
+}
+
+/// @brief Gets the factor to scale servo speeds by, relative to their stopped points.
+/// @return The speed factor, 1 at the nominal voltage.
+float Battery::speedScale()
+{
+    return compensation("batterySpeedGain");
+}
+
+/// @brief Gets the factor to scale linear move times by, making up the distance their scaled speeds don't.
+/// @return The time factor, 1 at the nominal voltage.
+float Battery::timeScale()
+{
+    return constrain(compensation("batteryTimeGain") / speedScale(), 0.5f, 2.0f);
+}
+
+/// @brief Calculates a compensation factor, assuming speed is proportional to voltage.
+/// @param gain The setting holding how strongly to compensate, from 0 for none to 1 for fully proportional.
+/// @return The factor, between 0.5 and 2.
+float Battery::compensation(const char* gain)
+{
+    float measured = voltage;
+    auto setting = config->TunableBotSettings.find(gain);
+    auto nominal = config->TunableBotSettings.find("batteryNominal");
+    if (measured <= 0 || setting == config->TunableBotSettings.end() || nominal == config->TunableBotSettings.end())
+    {
+        return 1;
+    }
+    return constrain(1 + setting->second.value * (nominal->second.value / measured - 1), 0.5f, 2.0f);
+}
+
+/// @brief Wraps the battery monitor task for static access.
+/// @param arg The Battery object.
+void Battery::BatteryTaskWrapper(void* arg)
+{
+    static_cast<Battery*>(arg)->BatteryTask();
+}
+
+/// @brief Runs in an infinite loop sampling and filtering the battery voltage.
+void Battery::BatteryTask()
+{
+    while (true)
+    {
+        sample();
+        vTaskDelay(SamplePeriod / portTICK_PERIOD_MS);
+    }
+}
+
+/// @brief Reads the ADC pin once and updates the filtered voltage.
+void Battery::sample()
+{
+    float measured = analogReadMilliVolts(pin) * divider / 1000;
+    // Exponentially weighted moving average smooths out servo current spikes
+    voltage = voltage == 0 ? measured : voltage + FilterWeight * (measured - voltage);
+    telemetry->updateBattery(voltage);
+}
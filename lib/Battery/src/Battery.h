@@ -0,0 +1,50 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Measures the battery voltage through an ADC pin and a resistor divider,
+ * and scales move speeds and timing to make up for the batteries discharging.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Configuration.h>
+#include <Telemetry.h>
+
+class Battery
+{
+    public:
+        Battery(Configuration* Config, Telemetry* Telem);
+        void begin();
+        float getVoltage();
+        float speedScale();
+        float timeScale();
+        void sample();
+        static void BatteryTaskWrapper(void* arg);
+
+    private:
+        /// @brief Time between voltage samples in milliseconds.
+        static const int SamplePeriod = 100;
+
+        /// @brief Weight of each new sample in the filtered voltage.
+        static constexpr float FilterWeight = 0.1;
+
+        /// @brief A reference to the shared configuration object.
+        Configuration* config;
+
+        /// @brief A reference to the shared telemetry object.
+        Telemetry* telemetry;
+
+        /// @brief The ADC pin, 0 if the voltage isn't measured.
+        int pin = 0;
+
+        /// @brief Ratio of the battery voltage to the voltage at the pin.
+        float divider = 1;
+
+        /// @brief The filtered battery voltage in volts, 0 until measured.
+        volatile float voltage = 0;
+
+        float compensation(const char* gain);
+        void BatteryTask();
+};
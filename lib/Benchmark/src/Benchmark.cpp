@@ -0,0 +1,151 @@
+#include "Benchmark.h"
+#include <CommandProcessor.h>
+
+#ifdef RUCKUS_BENCHMARK
+
+std::atomic<uint32_t> Benchmark::allocations { 0 };
+
+#ifndef RUCKUS_NATIVE
+// Allocation counters, the linker sends every call to these instead of the originals.
+// Native test builds count allocations in the test program instead, see test/test_benchmark.
+extern "C"
+{
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t count, size_t size);
+    void* __real_realloc(void* pointer, size_t size);
+
+    void* __wrap_malloc(size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __real_malloc(size);
+    }
+
+    void* __wrap_calloc(size_t count, size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __real_calloc(count, size);
+    }
+
+    void* __wrap_realloc(void* pointer, size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __real_realloc(pointer, size);
+    }
+}
+#endif
+
+/// @brief Creates a benchmark suite.
+/// @param Config A reference to the shared configuration object.
+/// @param Bot A reference to the robot object.
+/// @param Commands A reference to the command processor that runs the suite.
+Benchmark::Benchmark(Configuration* Config, RuckusBot* Bot, CommandProcessor* Commands)
+{
+    config = Config;
+    bot = Bot;
+    commands = Commands;
+}
+
+/// @brief Runs every benchmark. Call only from the command processor task while the robot is stopped.
+/// @return True if every benchmark was within its budget.
+bool Benchmark::run()
+{
+    Logger::info("Running benchmarks");
+    complete = false;
+    int i = 0;
+    // Budgets are generous estimates for an ESP32 at 240MHz, not yet measured on a robot, tighten them from GET /benchmark results
+    results[i++] = measure("getSettings", 100000, 200, [this]() {
+        String settings = config->getSettings();
+    });
+    String settings = config->getSettings();
+    results[i++] = measure("settingsRoundTrip", 4000000, 50, [this, &settings]() {
+        // Reapplying the same settings changes the version, so the next read serializes again
+        config->updateSettings(settings);
+        settings = config->getSettings();
+    });
+    // An empty settings patch, queued and dispatched the way the command task does for a web request
+    results[i++] = measure("commandQueue", 100000, 500, [this]() {
+        commands->AddSetupCommandToQueue(CommandProcessor::SetupCommands::UpdateSettings, "{}");
+        commands->ProcessNextCommand(0);
+    });
+    results[i++] = measure("display", 3000000, 50, [this]() {
+        bot->Display(bot->image_maps[RuckusBot::images::Duck], bot->color_map[RuckusBot::colors::White]);
+    });
+    RuckusBot::GyroHelper helper(bot->mpu6050, config);
+    results[i++] = measure("gyroIntegration", 2000000, 200, [&helper]() {
+        helper.getAngle();
+    });
+    results[i++] = measure("suppressedLog", 2000, 1000, []() {
+        Logger::debug("Benchmark %d", 1);
+    });
+    complete = true;
+    Logger::info("Benchmarks %s", passed() ? "passed" : "FAILED");
+    return passed();
+}
+
+/// @brief Gets the results of the last run.
+/// @return A JSON string of the results, times in nanoseconds per operation.
+String Benchmark::getResults()
+{
+    JsonDocument results_doc;
+    results_doc["passed"] = passed();
+    for (int i = 0; i < Count && complete; i++)
+    {
+        JsonObject result = results_doc["benchmarks"][results[i].name].to<JsonObject>();
+        result["iterations"] = results[i].iterations;
+        result["nsPerOp"] = results[i].nanoseconds;
+        result["allocationsPerOp"] = results[i].allocations;
+        result["budget"] = results[i].budget;
+        result["passed"] = results[i].nanoseconds <= results[i].budget;
+    }
+    String results_string;
+    serializeJson(results_doc, results_string);
+    return results_string;
+}
+
+/// @brief Checks if the suite has run.
+/// @return True if there are results.
+bool Benchmark::hasResults()
+{
+    return complete;
+}
+
+/// @brief Checks if every benchmark was within its budget.
+/// @return True if all passed.
+bool Benchmark::passed()
+{
+    for (int i = 0; i < Count && complete; i++)
+    {
+        if (results[i].nanoseconds > results[i].budget)
+        {
+            return false;
+        }
+    }
+    return complete;
+}
+
+/// @brief Times an operation.
+/// @param name The benchmark name.
+/// @param budget Slowest acceptable time per operation in nanoseconds.
+/// @param iterations Times to run the operation.
+/// @param operation The operation.
+/// @return The result.
+template <typename Operation>
+Benchmark::Result Benchmark::measure(const char* name, uint32_t budget, uint32_t iterations, Operation operation)
+{
+    // Warm up caches and any lazily allocated state
+    for (int i = 0; i < 5; i++)
+    {
+        operation();
+    }
+    uint32_t startAllocations = allocations.load(std::memory_order_relaxed);
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        operation();
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    uint32_t allocated = allocations.load(std::memory_order_relaxed) - startAllocations;
+    return Result { name, budget, iterations, elapsed * 1000.0f / iterations, (float)allocated / iterations };
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Times the firmware's hot paths on the robot and counts their heap allocations, failing any that exceed a time budget.
+ * Only included when built with -D RUCKUS_BENCHMARK (see the esp32dev-bench environment in platformio.ini),
+ * which also wraps malloc, calloc and realloc so allocations can be counted.
+ * The native environment runs the same suite on the host against a committed baseline, see test/test_benchmark.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+
+#ifdef RUCKUS_BENCHMARK
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <Configuration.h>
+#include <RuckusBot.h>
+
+class CommandProcessor;
+
+/// @brief Runs the benchmark suite and keeps the results.
+class Benchmark
+{
+    public:
+        Benchmark(Configuration* Config, RuckusBot* Bot, CommandProcessor* Commands);
+        bool run();
+        String getResults();
+        bool hasResults();
+        bool passed();
+
+        /// @brief Heap allocations since boot, counted by the malloc wrappers.
+        static std::atomic<uint32_t> allocations;
+
+    private:
+        /// @brief Number of benchmarks in the suite.
+        static const int Count = 6;
+
+        /// @brief Result of one benchmark.
+        struct Result
+        {
+            /// @brief The benchmark name.
+            const char* name;
+            /// @brief Slowest acceptable time per operation in nanoseconds.
+            uint32_t budget;
+            /// @brief Times the operation was run.
+            uint32_t iterations;
+            /// @brief Average time per operation in nanoseconds.
+            float nanoseconds;
+            /// @brief Average heap allocations per operation.
+            float allocations;
+        };
+
+        /// @brief A reference to the shared configuration object.
+        Configuration* config;
+
+        /// @brief A reference to the robot object.
+        RuckusBot* bot;
+
+        /// @brief A reference to the command processor that runs the suite.
+        CommandProcessor* commands;
+
+        /// @brief Results of the last run.
+        Result results[Count];
+
+        /// @brief True once the suite has run.
+        bool complete = false;
+
+        template <typename Operation>
+        Result measure(const char* name, uint32_t budget, uint32_t iterations, Operation operation);
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "BinaryCommandChannel.h"
+
+/// @brief Creates a binary command channel.
+/// @param Command A CommandProcessor object reference.
+BinaryCommandChannel::BinaryCommandChannel(CommandProcessor* Command)
+{
+    command = Command;
+}
+
+/// @brief Starts listening for commands.
+/// @return True on success.
+bool BinaryCommandChannel::begin()
+{
+    Serial.println("Starting binary command channel");
+    if (!udp.listen(Port))
+    {
+        Serial.println("Failed to start binary command channel");
+        return false;
+    }
+    udp.onPacket([this](AsyncUDPPacket& packet) {
+        this->onPacket(packet);
+    });
+    return true;
+}
+
+/// @brief Handles a received datagram and acknowledges it.
+/// @param packet The received packet.
+void BinaryCommandChannel::onPacket(AsyncUDPPacket& packet)
+{
+    AckPacket ack { Magic, Status::BadPacket, 0, 0 };
+    if (packet.length() == sizeof(CommandPacket))
+    {
+        CommandPacket received;
+        memcpy(&received, packet.data(), sizeof(CommandPacket));
+        if (received.magic == Magic)
+        {
+            ack.epoch = received.epoch;
+            ack.sequence = received.sequence;
+            // Sequence numbers from before a reset or rejoin belong to the last game
+            uint32_t current = command->getGameSession();
+            if (current != session)
+            {
+                senderCount = 0;
+                session = current;
+            }
+            uint32_t address = packet.remoteIP();
+            Sender* sender = findSender(address, packet.remotePort());
+            // A repeated sequence number is a retransmission after a lost acknowledgement, don't execute it twice
+            if (sender != NULL && sender->epoch == received.epoch && sender->sequence == received.sequence)
+            {
+                sender->lastSeen = millis();
+                ack.status = Status::Accepted;
+            }
+            else
+            {
+                ack.status = enqueue(received);
+                if (ack.status == Status::Accepted)
+                {
+                    remember(sender, address, packet.remotePort(), received);
+                }
+            }
+        }
+    }
+    packet.write((uint8_t*)&ack, sizeof(AckPacket));
+}
+
+/// @brief Passes a command to the command processor.
+/// @param packet The command to enqueue.
+/// @return The acknowledgement status.
+BinaryCommandChannel::Status BinaryCommandChannel::enqueue(const CommandPacket& packet)
+{
+    bool success;
+    switch (packet.opcode)
+    {
+        case Opcodes::Move:
+            success = command->AddCommandToQueue(CommandProcessor::CommandTypes::Movement, (CommandProcessor::Movements)packet.arguments[0], packet.arguments[1]);
+            break;
+        case Opcodes::AssignPlayer:
+            success = command->AddAssignPlayerCommandToQueue(packet.arguments[0], packet.arguments[1]);
+            break;
+        case Opcodes::TakeDamage:
+            success = command->AddDamageCommandToQueue(packet.arguments[0]);
+            break;
+        case Opcodes::Reset:
+            success = command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::Reset);
+            break;
+        default:
+            return Status::BadPacket;
+    }
+    return success ? Status::Accepted : Status::QueueFull;
+}
+
+/// @brief Finds the last accepted command from a sender.
+/// @param address The sender's IPv4 address.
+/// @param port The sender's UDP port.
+/// @return The sender, or NULL if it isn't remembered.
+BinaryCommandChannel::Sender* BinaryCommandChannel::findSender(uint32_t address, uint16_t port)
+{
+    for (int i = 0; i < senderCount; i++)
+    {
+        if (senders[i].address == address && senders[i].port == port)
+        {
+            return &senders[i];
+        }
+    }
+    return NULL;
+}
+
+/// @brief Records a sender's accepted command, replacing the oldest sender if there's no room.
+/// @param sender The sender if already remembered, otherwise NULL.
+/// @param address The sender's IPv4 address.
+/// @param port The sender's UDP port.
+/// @param packet The accepted command.
+void BinaryCommandChannel::remember(Sender* sender, uint32_t address, uint16_t port, const CommandPacket& packet)
+{
+    if (sender == NULL && senderCount < MaxSenders)
+    {
+        sender = &senders[senderCount++];
+    }
+    else if (sender == NULL)
+    {
+        sender = &senders[0];
+        for (int i = 1; i < MaxSenders; i++)
+        {
+            if (senders[i].lastSeen < sender->lastSeen)
+            {
+                sender = &senders[i];
+            }
+        }
+    }
+    *sender = Sender { address, port, packet.epoch, packet.sequence, millis() };
+}
@@ -0,0 +1,102 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Compact binary alternative to the HTTP command endpoints. Each command is a single
+ * fixed-size UDP datagram answered with an acknowledgement carrying the same epoch and sequence number.
+ * The sender picks a new epoch whenever it restarts its sequence numbers, e.g. when the game server starts.
+ * All multi-byte fields are little-endian.
+ *
+ * Command packet (9 bytes): magic 'R', opcode, uint8 epoch, uint16 sequence, int16 argument 1, int16 argument 2
+ * Acknowledgement (5 bytes): magic 'R', status, uint8 epoch, uint16 sequence
+ *
+ * Opcode arguments:
+ * Move: movement, magnitude (same values as the /move endpoint)
+ * AssignPlayer: player, botNumber
+ * TakeDamage: magnitude
+ * Reset: none
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <CommandProcessor.h>
+
+/// @brief Receives game commands as binary UDP datagrams.
+class BinaryCommandChannel
+{
+    public:
+        /// @brief The UDP port the channel listens on.
+        static const uint16_t Port = 8083;
+
+        /// @brief Marks a packet as belonging to this protocol.
+        static const uint8_t Magic = 'R';
+
+        /// @brief Commands that can be sent over the channel.
+        enum Opcodes : uint8_t { Move = 1, AssignPlayer = 2, TakeDamage = 3, Reset = 4 };
+
+        /// @brief Acknowledgement status codes.
+        enum Status : uint8_t { Accepted = 0, QueueFull = 1, BadPacket = 2 };
+
+        BinaryCommandChannel(CommandProcessor* Command);
+        bool begin();
+
+    private:
+        /// @brief Layout of a command packet.
+        struct __attribute__((packed)) CommandPacket
+        {
+            uint8_t magic;
+            uint8_t opcode;
+            uint8_t epoch;
+            uint16_t sequence;
+            int16_t arguments[2];
+        };
+
+        /// @brief Layout of an acknowledgement packet.
+        struct __attribute__((packed)) AckPacket
+        {
+            uint8_t magic;
+            uint8_t status;
+            uint8_t epoch;
+            uint16_t sequence;
+        };
+
+        /// @brief The last accepted command from one sender, used to ignore its retransmissions.
+        struct Sender
+        {
+            /// @brief The sender's IPv4 address.
+            uint32_t address;
+            /// @brief The sender's UDP port.
+            uint16_t port;
+            /// @brief Epoch of the command.
+            uint8_t epoch;
+            /// @brief Sequence number of the command.
+            uint16_t sequence;
+            /// @brief Time of the sender's last command in milliseconds, the oldest sender is forgotten first.
+            unsigned long lastSeen;
+        };
+
+        /// @brief Most senders remembered at once.
+        static const int MaxSenders = 4;
+
+        /// @brief A reference to a CommandProcessor object.
+        CommandProcessor* command;
+
+        /// @brief UDP listener.
+        AsyncUDP udp;
+
+        /// @brief Senders of recently accepted commands.
+        Sender senders[MaxSenders];
+
+        /// @brief Number of remembered senders.
+        int senderCount = 0;
+
+        /// @brief Game session the senders were remembered in, they're forgotten when it changes.
+        uint32_t session = 0;
+
+        void onPacket(AsyncUDPPacket& packet);
+        Status enqueue(const CommandPacket& packet);
+        Sender* findSender(uint32_t address, uint16_t port);
+        void remember(Sender* sender, uint32_t address, uint16_t port, const CommandPacket& packet);
+};
@@ -0,0 +1,68 @@
+#include "BootTimeline.h"
+
+BootTimeline::Phase BootTimeline::phases[BootTimeline::MaxPhases];
+int BootTimeline::count = 0;
+uint32_t BootTimeline::readyTime = 0;
+bool BootTimeline::warmRestart = false;
+portMUX_TYPE BootTimeline::lock = portMUX_INITIALIZER_UNLOCKED;
+
+/// @brief Records that a boot phase finished.
+/// @param phase The phase name, must be a string literal.
+void BootTimeline::mark(const char* phase)
+{
+    // The timer starts with the application, a few hundred milliseconds after power-on
+    uint32_t time = esp_timer_get_time() / 1000;
+    uint32_t previous = 0;
+    portENTER_CRITICAL(&lock);
+    if (count > 0)
+    {
+        previous = phases[count - 1].time;
+    }
+    if (count < MaxPhases)
+    {
+        phases[count++] = Phase { phase, time };
+    }
+    portEXIT_CRITICAL(&lock);
+    Logger::info("Boot: %s at %ums (+%ums)", phase, time, time - previous);
+}
+
+/// @brief Records that the robot is ready to play, the end of the boot.
+void BootTimeline::ready()
+{
+    mark("Ready");
+    readyTime = esp_timer_get_time() / 1000;
+    Logger::info("Ready %ums after %s", readyTime, warmRestart ? "a warm restart" : "power-on");
+}
+
+/// @brief Records whether the robot restored its game assignment from before a reset.
+/// @param warm True for a warm restart.
+void BootTimeline::setWarmRestart(bool warm)
+{
+    warmRestart = warm;
+}
+
+/// @brief Gets the boot timeline.
+/// @return A JSON string of the time to ready, the reset reason and each phase's finish time and duration in milliseconds.
+String BootTimeline::getTimeline()
+{
+    JsonDocument timeline_doc;
+    timeline_doc["ready"] = readyTime;
+    timeline_doc["warmRestart"] = warmRestart;
+    timeline_doc["resetReason"] = (int)esp_reset_reason();
+    JsonArray phase_list = timeline_doc["phases"].to<JsonArray>();
+    portENTER_CRITICAL(&lock);
+    Phase copy[MaxPhases];
+    int copied = count;
+    memcpy(copy, phases, sizeof(Phase) * copied);
+    portEXIT_CRITICAL(&lock);
+    for (int i = 0; i < copied; i++)
+    {
+        JsonObject phase = phase_list.add<JsonObject>();
+        phase["phase"] = copy[i].name;
+        phase["time"] = copy[i].time;
+        phase["duration"] = copy[i].time - (i > 0 ? copy[i - 1].time : 0);
+    }
+    String timeline_string;
+    serializeJson(timeline_doc, timeline_string);
+    return timeline_string;
+}
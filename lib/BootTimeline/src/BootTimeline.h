@@ -0,0 +1,43 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Records when each boot phase finished, so the time from power-on to ready can be tracked
+ * and the slowest phase found. Phases can be marked from any task.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <Logger.h>
+
+class BootTimeline
+{
+    public:
+        static void mark(const char* phase);
+        static void ready();
+        static void setWarmRestart(bool warm);
+        static String getTimeline();
+
+    private:
+        /// @brief Most phases recorded.
+        static const int MaxPhases = 16;
+
+        /// @brief A finished boot phase.
+        struct Phase
+        {
+            /// @brief The phase name, must be a string literal.
+            const char* name;
+            /// @brief Time the phase finished in milliseconds since power-on.
+            uint32_t time;
+        };
+
+        static Phase phases[MaxPhases];
+        static int count;
+        static uint32_t readyTime;
+        static bool warmRestart;
+        static portMUX_TYPE lock;
+};
@@ -0,0 +1,113 @@
+#include "Buttons.h"
+
+/// @brief Creates a button handler.
+/// @param Command A reference to the command processor.
+/// @param APin The pin of button A.
+/// @param BPin The pin of button B.
+Buttons::Buttons(CommandProcessor* Command, int APin, int BPin)
+{
+    command = Command;
+    pins[Button::A] = APin;
+    pins[Button::B] = BPin;
+}
+
+/// @brief Starts watching the buttons.
+void Buttons::begin()
+{
+    xTaskCreate(Buttons::ButtonTaskWrapper, "Buttons", 2048, this, 1, &task);
+    pinMode(pins[Button::A], INPUT_PULLUP);
+    pinMode(pins[Button::B], INPUT_PULLUP);
+    attachInterruptArg(pins[Button::A], Buttons::onEdgeA, this, CHANGE);
+    attachInterruptArg(pins[Button::B], Buttons::onEdgeB, this, CHANGE);
+}
+
+/// @brief Wraps the button task for static access.
+/// @param arg The Buttons object.
+void Buttons::ButtonTaskWrapper(void* arg)
+{
+    static_cast<Buttons*>(arg)->ButtonTask();
+}
+
+/// @brief Wakes the button task when button A changes.
+/// @param arg The Buttons object.
+void IRAM_ATTR Buttons::onEdgeA(void* arg)
+{
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(static_cast<Buttons*>(arg)->task, 1 << Button::A, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/// @brief Wakes the button task when button B changes.
+/// @param arg The Buttons object.
+void IRAM_ATTR Buttons::onEdgeB(void* arg)
+{
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(static_cast<Buttons*>(arg)->task, 1 << Button::B, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/// @brief Sleeps until a button changes, then debounces it and posts presses.
+void Buttons::ButtonTask()
+{
+    uint32_t edges;
+    while (true)
+    {
+        // Sleep until an edge, or until a held button becomes a long press
+        TickType_t wait = portMAX_DELAY;
+        for (int i = 0; i < 2; i++)
+        {
+            if (pressed[i] && !longPressed[i])
+            {
+                long remaining = LongPressTime - (long)(millis() - pressedAt[i]);
+                wait = min(wait, (TickType_t)(max(remaining, 0L) / portTICK_PERIOD_MS));
+            }
+        }
+        if (xTaskNotifyWait(0, UINT32_MAX, &edges, wait) == pdTRUE)
+        {
+            // Let the contacts settle, then read the level rather than trusting the edge.
+            // This also ignores the short glitches pins 36 and 39 see when the ADC or Wi-Fi powers up.
+            vTaskDelay(DebounceTime / portTICK_PERIOD_MS);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            bool down = digitalRead(pins[i]) == LOW;
+            if (down && !pressed[i])
+            {
+                pressed[i] = true;
+                longPressed[i] = false;
+                pressedAt[i] = millis();
+            }
+            else if (!down && pressed[i])
+            {
+                pressed[i] = false;
+                if (!longPressed[i])
+                {
+                    shortPress((Button)i);
+                }
+            }
+            // Long presses fire while the button is still held so the robot responds without waiting for the release
+            if (pressed[i] && !longPressed[i] && millis() - pressedAt[i] >= LongPressTime)
+            {
+                longPressed[i] = true;
+                longPress((Button)i);
+            }
+        }
+    }
+}
+
+/// @brief Posts the command for a short press.
+/// @param button The button pressed.
+void Buttons::shortPress(Button button)
+{
+    Logger::info("Button %c pressed", button == Button::A ? 'A' : 'B');
+    command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, button == Button::A ? CommandProcessor::ConfigCommands::CalibrateGyro : CommandProcessor::ConfigCommands::ShowIP);
+}
+
+/// @brief Posts the command for a long press.
+/// @param button The button held.
+void Buttons::longPress(Button button)
+{
+    Logger::info("Button %c held", button == Button::A ? 'A' : 'B');
+    // Holding A calibrates like a press, holding B joins the game again
+    command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, button == Button::A ? CommandProcessor::ConfigCommands::CalibrateGyro : CommandProcessor::ConfigCommands::Rejoin);
+}
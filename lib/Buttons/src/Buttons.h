@@ -0,0 +1,54 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Watches the A and B buttons with pin interrupts, debounces them and posts
+ * short and long presses to the command processor as commands.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <CommandProcessor.h>
+
+class Buttons
+{
+    public:
+        /// @brief The buttons.
+        enum Button { A, B };
+
+        Buttons(CommandProcessor* Command, int APin, int BPin);
+        void begin();
+        static void ButtonTaskWrapper(void* arg);
+
+    private:
+        /// @brief Time for a button's contacts to settle in milliseconds.
+        static const int DebounceTime = 30;
+
+        /// @brief Time a button must be held for a long press in milliseconds.
+        static const int LongPressTime = 1500;
+
+        /// @brief A reference to the command processor.
+        CommandProcessor* command;
+
+        /// @brief The pin of each button, pulled low when pressed.
+        int pins[2];
+
+        /// @brief The task handling button presses, notified by the interrupts.
+        TaskHandle_t task = NULL;
+
+        /// @brief True while each button is held down.
+        bool pressed[2] = { false, false };
+
+        /// @brief True once a held button's long press has been posted.
+        bool longPressed[2] = { false, false };
+
+        /// @brief Time each button was pressed in milliseconds.
+        unsigned long pressedAt[2] = { 0, 0 };
+
+        static void IRAM_ATTR onEdgeA(void* arg);
+        static void IRAM_ATTR onEdgeB(void* arg);
+        void ButtonTask();
+        void shortPress(Button button);
+        void longPress(Button button);
+};
@@ -2,43 +2,41 @@
 
 /// @brief Processes and dispatches commands received by the robot.
 /// @param bot A reference to a RuckusBot object.
-CommandProcessor::CommandProcessor(RuckusBot* Bot, Configuration* Config, HTTPCommunication* Communication)
+/// @param Telem A reference to a Telemetry object.
+/// @param Batt A reference to the battery monitor.
+/// @param Sim A reference to the simulator used to replay moves.
+CommandProcessor::CommandProcessor(RuckusBot* Bot, Configuration* Config, HTTPCommunication* Communication, Telemetry* Telem, Battery* Batt, Simulator* Sim)
+#ifdef RUCKUS_BENCHMARK
+    : benchmark(Config, Bot, this)
+#endif
 {
     bot = Bot;
     config = Config;
     communication = Communication;
-    // Uses size 4 int arrays, only three are used, fourth is for future use.
-    CommandQueue = xQueueCreate(5, sizeof(int[4]));
-    CommandPayloadQueue = xQueueCreate(5, sizeof(String*));
+    telemetry = Telem;
+    battery = Batt;
+    simulator = Sim;
+    CommandQueue = xQueueCreate(5, sizeof(QueuedCommand));
 }
 
 /// @brief Adds a command to the queue.
 /// @param type The command type.
 /// @param move The type of move.
 /// @param magnitude The magnitude of the move.
-/// @param OutOfTurn If the move is out of turn.
+/// @param executeAt Game server time in milliseconds to start the move at, 0 to start as soon as possible.
 /// @return True on success.
-bool CommandProcessor::AddCommandToQueue(CommandTypes type, Movements move, int magnitude)
+bool CommandProcessor::AddCommandToQueue(CommandTypes type, Movements move, int magnitude, double executeAt)
 {
-    return AddToQueue(new int[4] { type, move, magnitude, 0 });
+    return AddToQueue(QueuedCommand { type, move, { magnitude, 0 }, NULL, executeAt });
 }
 
 /// @brief Adds a command to the queue.
 /// @param type The command type.
 /// @param command The type configuration command.
-/// @param payload Any data payload associated with the command.
 /// @return True on success.
-bool CommandProcessor::AddCommandToQueue(CommandTypes type, ConfigCommands command, String payload)
+bool CommandProcessor::AddCommandToQueue(CommandTypes type, ConfigCommands command)
 {
-    if (AddToQueue(new int[4] {type, command, 0, 0}))
-    {
-        String *payload_ptr = new String(payload);
-        if (xQueueSend(CommandPayloadQueue, &payload_ptr, 10) != pdTRUE)
-        {
-            return true;
-        }
-    }
-    return false;
+    return AddToQueue(QueuedCommand { type, command, { 0, 0 }, NULL, 0 });
 }
 
 /// @brief Adds a command to the queue for the robot to take damage.
@@ -46,7 +44,34 @@ bool CommandProcessor::AddCommandToQueue(CommandTypes type, ConfigCommands comma
 /// @return True on success.
 bool CommandProcessor::AddDamageCommandToQueue(int magnitude) 
 {
-    return AddToQueue(new int[4] {CommandTypes::Damage, magnitude, 0, 0});
+    return AddToQueue(QueuedCommand { CommandTypes::Damage, magnitude, { 0, 0 }, NULL, 0 });
+}
+
+/// @brief Adds a command to the queue assigning a player to the robot.
+/// @param player The player number to assign.
+/// @param botNumber The robot number assigned by the game server.
+/// @return True on success.
+bool CommandProcessor::AddAssignPlayerCommandToQueue(int player, int botNumber)
+{
+    return AddToQueue(QueuedCommand { CommandTypes::Config, ConfigCommands::AssignPlayer, { player, botNumber }, NULL, 0 });
+}
+
+/// @brief Adds a command to the queue to show an image on the screen.
+/// @param image The image to show.
+/// @param cache Save the image as the current image.
+/// @return True on success.
+bool CommandProcessor::AddImageCommandToQueue(RuckusBot::images image, bool cache)
+{
+    return AddToQueue(QueuedCommand { CommandTypes::Config, ConfigCommands::UpdateImage, { image, cache }, NULL, 0 });
+}
+
+/// @brief Adds a command to the queue to select or save a tuning profile.
+/// @param command Either SelectProfile or SaveProfile.
+/// @param name The profile name.
+/// @return True on success.
+bool CommandProcessor::AddProfileCommandToQueue(ConfigCommands command, String name)
+{
+    return AddToQueue(QueuedCommand { CommandTypes::Config, command, { 0, 0 }, new String(name), 0 });
 }
 
 /// @brief Adds a command to the queue when the robot is in setup mode. 
@@ -55,16 +80,49 @@ bool CommandProcessor::AddDamageCommandToQueue(int magnitude)
 /// @return True on success.
 bool CommandProcessor::AddSetupCommandToQueue(SetupCommands command, String payload)
 {
-    if (AddToQueue(new int[4] {CommandTypes::Setup, command, 0, 0}))
-    {
-        String *payload_ptr = new String(payload);
-        if (xQueueSend(CommandPayloadQueue, &payload_ptr, 10) != pdTRUE)
-        {
-            return true;
-        }
-    }
-    return false;
+    return AddToQueue(QueuedCommand { CommandTypes::Setup, command, { 0, 0 }, new String(payload), 0 });
+}
+
+/// @brief Gets the results of the last automatic servo calibration.
+/// @return A JSON string of the calibration results.
+String CommandProcessor::GetCalibration()
+{
+    return bot->getCalibration();
+}
+
+/// @brief Gets the heading drift at rest and the gyro bias model.
+/// @return A JSON string of the drift measurements and the model.
+String CommandProcessor::GetGyroDrift()
+{
+    return bot->getGyroDrift();
+}
+
+/// @brief Gets a counter of the games played, so state kept for a game can be dropped when it ends.
+/// @return The number of resets and rejoins since boot.
+uint32_t CommandProcessor::getGameSession()
+{
+    return gameSession;
+}
+
+/// @brief Gets the results of the last replay.
+/// @param passed Set to true if every scenario passed.
+/// @return A JSON string of the results.
+String CommandProcessor::GetReplayResults(bool& passed)
+{
+    passed = simulator->passed();
+    return simulator->getResults();
+}
+
+#ifdef RUCKUS_BENCHMARK
+/// @brief Gets the results of the last benchmark run.
+/// @param passed Set to true if every benchmark was within its budget.
+/// @return A JSON string of the results.
+String CommandProcessor::GetBenchmarkResults(bool& passed)
+{
+    passed = benchmark.passed();
+    return benchmark.getResults();
 }
+#endif
 
 /// @brief Wraps the command processor task for static access.
 /// @param arg The CommandProcessor object.
@@ -75,71 +133,87 @@ void CommandProcessor::CommandProcessorTaskWrapper(void* arg){
 /// @brief Runs in an infinite loop to process commands in the command queue.
 void CommandProcessor::ProcessTask()
 {
-    int command[4];
-    String *payload = NULL;
     while(true) 
     {
-        if (xQueueReceive(CommandQueue, &command, 10) == pdTRUE)
+        if (!ProcessNextCommand(10))
         {
-            Serial.println("Processing command");
-            switch (command[0])
+            // Track the gyro bias as the robot warms up while nothing else is happening
+            if (millis() - lastCommand > BiasSampleIdleTime)
             {
-                case CommandTypes::Movement:
-                    ExecuteMoveCommand((Movements)command[1], command[2]);
-                    break;
-                case CommandTypes::Damage:
-                    bot->takeDamage(command[1]);
-                    break;
-                case CommandTypes::Config:
-                    // Receive payload.
-                    if (xQueueReceive(CommandPayloadQueue, &payload, 500 / portTICK_PERIOD_MS) == pdTRUE)
-                    {
-                        Serial.print("Payload: ");
-                        Serial.println(*payload);
-                        ExecuteConfigCommand((ConfigCommands)command[1], *payload);
-                        delete payload;
-                    }
-                    else
-                    {
-                        Serial.println("Missing or bad config data payload.");
-                    }
-                    break;
-                case CommandTypes::Setup:
-                    // Receive payload.
-                    if (xQueueReceive(CommandPayloadQueue, &payload, 500 / portTICK_PERIOD_MS) == pdTRUE)
-                    {
-                        Serial.print("Payload: ");
-                        Serial.println(*payload);
-                        ExecuteSetupCommand((SetupCommands)command[1], *payload);                        
-                        delete payload;
-                    }
-                    else
-                    {
-                        Serial.println("Missing or bad setup data payload.");
-                    }
-                    break;
-                
-                default:
-                    Serial.print("Bad command: ");
-                    Serial.println(command[0]);
-                    break;
+                bot->sampleGyroBias();
             }
         }
 
+        // Write settings changes once they stop arriving
+        config->flushSettings();
+
         // Wait before checking again
         vTaskDelay(50 / portTICK_PERIOD_MS);
     }
 }
 
+/// @brief Takes the next command from the queue and executes it.
+/// @param wait Ticks to wait for a command.
+/// @return True if a command was processed.
+bool CommandProcessor::ProcessNextCommand(TickType_t wait)
+{
+    QueuedCommand command;
+    if (xQueueReceive(CommandQueue, &command, wait) != pdTRUE)
+    {
+        return false;
+    }
+    Logger::debug("Processing command %d:%d", command.type, command.command);
+    telemetry->updateCommand(command.type, command.command, uxQueueMessagesWaiting(CommandQueue));
+    if (command.payload != NULL)
+    {
+        Logger::debug("Payload: %s", command.payload->c_str());
+    }
+    PROFILE_SCOPE("Execute command");
+    switch (command.type)
+    {
+        case CommandTypes::Movement:
+            ExecuteMoveCommand((Movements)command.command, command.arguments[0], command.executeAt);
+            break;
+        case CommandTypes::Damage:
+            bot->takeDamage(command.command);
+            break;
+        case CommandTypes::Config:
+            ExecuteConfigCommand((ConfigCommands)command.command, command.arguments, command.payload);
+            break;
+        case CommandTypes::Setup:
+            if (command.payload != NULL)
+            {
+                ExecuteSetupCommand((SetupCommands)command.command, *command.payload);
+            }
+            else
+            {
+                Logger::warning("Missing or bad setup data payload.");
+            }
+            break;
+        
+        default:
+            Logger::warning("Bad command: %d", command.type);
+            break;
+    }
+    delete command.payload;
+    telemetry->updateCommand(Telemetry::Idle, 0, uxQueueMessagesWaiting(CommandQueue));
+    lastCommand = millis();
+    return true;
+}
+
 /// @brief Executes a movement command.
 /// @param move The movement command to execute.
 /// @param magnitude The magnitude of the movement.
-/// @param OutOfTurn If the movement is out of turn (WIP).
-void CommandProcessor::ExecuteMoveCommand(Movements move, int magnitude)
+/// @param executeAt Game server time in milliseconds to start the movement at, 0 to start immediately.
+void CommandProcessor::ExecuteMoveCommand(Movements move, int magnitude, double executeAt)
 {
+    if (executeAt > 0)
+    {
+        WaitUntil(executeAt);
+    }
     if (magnitude > 0)
     {
-        Serial.println("Moving");
+        Logger::info("Moving");
         switch (move)
         {
             case Movements::Left:
@@ -170,28 +244,71 @@ void CommandProcessor::ExecuteMoveCommand(Movements move, int magnitude)
     communication->SignalDone(config->BotConfig.RobotNumber);
 }
 
+/// @brief Waits until a game server time is reached.
+/// @param serverTime The game server time in milliseconds.
+void CommandProcessor::WaitUntil(double serverTime)
+{
+    int64_t target;
+    if (!communication->serverToLocal(serverTime, target))
+    {
+        Logger::warning("Clock not synchronized, starting now");
+        return;
+    }
+    int64_t remaining = target - esp_timer_get_time();
+    if (remaining > MaxScheduleAhead * 1000)
+    {
+        // A bad server time or clock fit, don't leave the robot waiting for it
+        Logger::warning("Scheduled move is %lldms ahead, more than %lldms, starting now", remaining / 1000, MaxScheduleAhead);
+        return;
+    }
+    // Sleep in whole ticks while more than a tick is left, a delay can end up to a tick early at a tick boundary
+    const int64_t tick = portTICK_PERIOD_MS * 1000;
+    if (remaining > 2 * tick)
+    {
+        vTaskDelay(remaining / tick - 1);
+    }
+    while (target - esp_timer_get_time() > tick)
+    {
+        vTaskDelay(1);
+    }
+    while (esp_timer_get_time() < target)
+    {
+        // Spin for the part of a tick left
+    }
+    int64_t error = esp_timer_get_time() - target;
+    communication->recordScheduledStart(error);
+    if (error > 1000)
+    {
+        Logger::warning("Scheduled move started %lldus late", error);
+    }
+}
+
 /// @brief Executes a configuration command.
 /// @param command The command to execute.
-/// @param payload Data payload accompanying command.
-void CommandProcessor::ExecuteConfigCommand(ConfigCommands command, String payload)
+/// @param arguments Numeric arguments accompanying command.
+/// @param payload Data payload accompanying command, NULL if not used.
+void CommandProcessor::ExecuteConfigCommand(ConfigCommands command, int arguments[2], String* payload)
 {
     switch (command)
     {
         case ConfigCommands::AssignPlayer:   
-        {         
-            int player = payload.substring(0, payload.indexOf(":")).toInt();
-            int botNumber = payload.substring(payload.indexOf(":") + 1).toInt();
+        {
+            int player = arguments[0];
+            int botNumber = arguments[1];
             if (player != 0)
             {
                 bot->playerAssigned(player);
                 config->BotConfig.RobotNumber = botNumber;
                 config->BotConfig.PlayerNumber = player;
+                WarmRestart::setAssignment(player, botNumber);
             }
             break;
         }
         case ConfigCommands::Reset:
             bot->reset();
             config->BotConfig.PlayerNumber = 0;
+            WarmRestart::setAssignment(0, config->BotConfig.RobotNumber);
+            gameSession++;
             break;
         case ConfigCommands::Ready:
             bot->ready();
@@ -200,12 +317,36 @@ void CommandProcessor::ExecuteConfigCommand(ConfigCommands command, String paylo
             bot->notReady();
             break;
         case ConfigCommands::UpdateImage:
-        {
-            int image = payload.substring(0, payload.indexOf(":")).toInt();
-            int shouldCache = payload.substring(payload.indexOf(":") + 1).toInt();
-            bot->showImage((RuckusBot::images)image, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value, shouldCache == 1 ? true : false);
+            bot->showImage((RuckusBot::images)arguments[0], (RuckusBot::colors)config->TunableBotSettings["robotColor"].value, arguments[1] == 1 ? true : false);
+            break;
+        case ConfigCommands::SelectProfile:
+            if (payload != NULL)
+                config->selectProfile(*payload);
+            break;
+        case ConfigCommands::SaveProfile:
+            if (payload != NULL)
+                config->saveProfile(*payload);
+            break;
+        case ConfigCommands::CalibrateGyro:
+            bot->showImage(RuckusBot::images::Duck, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value, false);
+            bot->calibrateGyro();
+            bot->showImage(bot->currentImage, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            break;
+        case ConfigCommands::ShowIP:
+            bot->showIP();
+            bot->showImage(bot->currentImage, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            break;
+        case ConfigCommands::Rejoin:
+            gameSession++;
+            if (communication->JoinGame(config->BotConfig.RobotName, battery->getVoltage(), config->BotConfig.PlayerNumber, config->BotConfig.RobotNumber))
+            {
+                bot->ready();
+            }
+            else
+            {
+                bot->notReady();
+            }
             break;
-        }
     }
 }
 
@@ -233,6 +374,47 @@ void CommandProcessor::ExecuteSetupCommand(SetupCommands command, String payload
                 bot->navigationTest();
             }
             break;
+        case SetupCommands::UpdateSettings:
+            if(bot->inSetupMode)
+                config->patchSettings(payload);
+            break;
+        case SetupCommands::Calibrate:
+            if(bot->inSetupMode)
+            {
+                bot->autoCalibrate();
+                bot->showImage(RuckusBot::images::Duck, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            }
+            break;
+        case SetupCommands::IdentifyServos:
+            if(bot->inSetupMode)
+            {
+                bot->showImage(bot->identifyServos() ? RuckusBot::images::Duck : RuckusBot::images::Sad, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            }
+            break;
+        case SetupCommands::RunBenchmark:
+            if(bot->inSetupMode)
+            {
+                #ifdef RUCKUS_BENCHMARK
+                bot->showImage(benchmark.run() ? RuckusBot::images::Duck : RuckusBot::images::Sad, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+                #else
+                Logger::warning("Benchmarks not built, use the esp32dev-bench environment");
+                #endif
+            }
+            break;
+        case SetupCommands::Replay:
+            if(bot->inSetupMode)
+            {
+                bot->showImage(simulator->run(bot, payload) ? RuckusBot::images::Duck : RuckusBot::images::Sad, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            }
+            break;
+        case SetupCommands::MeasureDrift:
+            if(bot->inSetupMode)
+            {
+                // Optional duration in seconds
+                bot->measureDrift(payload.toInt() > 0 ? payload.toInt() * 1000 : 30000);
+                bot->showImage(RuckusBot::images::Duck, (RuckusBot::colors)config->TunableBotSettings["robotColor"].value);
+            }
+            break;
         case SetupCommands::Exit:
             if(bot->inSetupMode && config->updateSettings(payload))
                 config->saveSettings();
@@ -245,14 +427,20 @@ void CommandProcessor::ExecuteSetupCommand(SetupCommands command, String payload
 }
 
 /// @brief Adds a command to the command queue.
-/// @param command The command.
+/// @param command The command. Its payload is deleted if it can't be queued.
 /// @return True on success.
-bool CommandProcessor::AddToQueue(int command[4]) 
+bool CommandProcessor::AddToQueue(QueuedCommand command) 
 {
-    Serial.println("Adding command to queue");
-    if (xQueueSend(CommandQueue, (void*)command, 10) != pdTRUE)
+    Logger::debug("Adding command to queue");
+    BaseType_t queued;
+    {
+        PROFILE_SCOPE("Queue send");
+        queued = xQueueSend(CommandQueue, &command, 10);
+    }
+    if (queued != pdTRUE)
     {
-        Serial.println("Queue full");
+        Logger::warning("Queue full");
+        delete command.payload;
         return false;
     }
     return true;
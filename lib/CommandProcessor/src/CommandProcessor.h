@@ -9,6 +9,13 @@
 #include <RuckusBot.h>
 #include <Configuration.h>
 #include <HTTPCommunication.h>
+#include <Telemetry.h>
+#include <Battery.h>
+#include <Simulator.h>
+#include <WarmRestart.h>
+#include <Profiler.h>
+#include <Logger.h>
+#include <Benchmark.h>
 
 class CommandProcessor 
 {
@@ -17,22 +24,47 @@ class CommandProcessor
         enum CommandTypes { Movement, Config, Damage, Setup };
 
         /// @brief Allowed types of configuration commands.
-        enum ConfigCommands { AssignPlayer, Reset, Ready, NotReady, UpdateImage };
+        enum ConfigCommands { AssignPlayer, Reset, Ready, NotReady, UpdateImage, SelectProfile, SaveProfile, CalibrateGyro, ShowIP, Rejoin };
 
         /// @brief Allowed types of commands for when in setup mode.
-        enum SetupCommands { Enter, SpeedTest, NavigationTest, Exit };
+        enum SetupCommands { Enter, SpeedTest, NavigationTest, Exit, UpdateSettings, Calibrate, IdentifyServos, RunBenchmark, Replay, MeasureDrift };
         
         /// @brief Allowed types of movement commands.
         enum Movements { Left, Right, Forward, Backward, LeftLateral, RightLateral };
 
-        CommandProcessor(RuckusBot* Bot, Configuration* Config, HTTPCommunication* Communication);
-        bool AddCommandToQueue(CommandTypes type, Movements move, int magnitude);
-        bool AddCommandToQueue(CommandTypes type, ConfigCommands command, String payload = "");
+        CommandProcessor(RuckusBot* Bot, Configuration* Config, HTTPCommunication* Communication, Telemetry* Telem, Battery* Batt, Simulator* Sim);
+        bool AddCommandToQueue(CommandTypes type, Movements move, int magnitude, double executeAt = 0);
+        bool AddCommandToQueue(CommandTypes type, ConfigCommands command);
         bool AddSetupCommandToQueue(SetupCommands command, String payload);
         bool AddDamageCommandToQueue(int magnitude);
+        bool AddAssignPlayerCommandToQueue(int player, int botNumber);
+        bool AddImageCommandToQueue(RuckusBot::images image, bool cache);
+        bool AddProfileCommandToQueue(ConfigCommands command, String name);
+        String GetCalibration();
+        String GetReplayResults(bool& passed);
+        String GetGyroDrift();
+        uint32_t getGameSession();
+        #ifdef RUCKUS_BENCHMARK
+        String GetBenchmarkResults(bool& passed);
+        #endif
         static void CommandProcessorTaskWrapper(void* arg);
 
     private:
+        /// @brief A command waiting in the command queue.
+        struct QueuedCommand
+        {
+            /// @brief The command type.
+            CommandTypes type;
+            /// @brief The command, interpreted according to the command type.
+            int command;
+            /// @brief Numeric arguments of the command.
+            int arguments[2];
+            /// @brief Optional data payload, deleted once the command is processed. NULL if not used.
+            String* payload;
+            /// @brief Game server time in milliseconds to start the command at, 0 to start immediately.
+            double executeAt;
+        };
+
         /// @brief A reference to a robot object.
         RuckusBot* bot;
 
@@ -42,14 +74,43 @@ class CommandProcessor
         /// @brief A reference to a HTTPCommunication object.
         HTTPCommunication* communication;
 
+        /// @brief A reference to a Telemetry object.
+        Telemetry* telemetry;
+
+        /// @brief A reference to the battery monitor.
+        Battery* battery;
+
+        /// @brief A reference to the simulator used to replay moves.
+        Simulator* simulator;
+
         /// @brief Queue to hold commands to be processed.
         QueueHandle_t CommandQueue;
-        /// @brief Queue to hold data payloads for config commands.
-        QueueHandle_t CommandPayloadQueue;
 
-        bool AddToQueue(int command[4]);
+        /// @brief Time the last command finished in milliseconds.
+        unsigned long lastCommand = 0;
+
+        /// @brief Incremented whenever the robot is reset or rejoins the game.
+        volatile uint32_t gameSession = 0;
+
+        /// @brief Time without commands before the gyro bias is sampled, in milliseconds.
+        static const unsigned long BiasSampleIdleTime = 10000;
+
+        /// @brief Furthest ahead a move can be scheduled, in milliseconds. Later start times are treated as clock errors.
+        static const int64_t MaxScheduleAhead = 5000;
+
+        #ifdef RUCKUS_BENCHMARK
+        /// @brief Benchmark suite, run from the command task so it never races a move.
+        Benchmark benchmark;
+
+        /// @brief Lets the benchmark suite time queueing and dispatching a command.
+        friend class Benchmark;
+        #endif
+
+        bool AddToQueue(QueuedCommand command);
         void ProcessTask();
-        void ExecuteConfigCommand(ConfigCommands command, String payload);
-        void ExecuteMoveCommand(Movements move, int magnitude);
+        bool ProcessNextCommand(TickType_t wait);
+        void ExecuteConfigCommand(ConfigCommands command, int arguments[2], String* payload);
+        void ExecuteMoveCommand(Movements move, int magnitude, double executeAt);
+        void WaitUntil(double serverTime);
         void ExecuteSetupCommand(SetupCommands command, String payload);
 };
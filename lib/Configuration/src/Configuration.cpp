@@ -1,5 +1,15 @@
 #include "Configuration.h"
 
+/// @brief Creates a configuration object.
+Configuration::Configuration() {
+    storageLock = xSemaphoreCreateMutex();
+    cacheLock = xSemaphoreCreateMutex();
+    bootNonce = esp_random();
+    memset(profiles, 0, sizeof(profiles));
+    memset(velocityTables, 0, sizeof(velocityTables));
+    memset(&biasModel, 0, sizeof(biasModel));
+}
+
 /// @brief Called when a robot has new settings.
 /// @param settings A JSON object of new parameters.
 /// @return True on success.
@@ -7,19 +17,22 @@ bool Configuration::updateSettings(String settings) {
     if (settings != "") {
         // Prase settings string
         settings.trim();
-        Serial.println("New settings : " + settings);
+        Logger::debug("New settings : %s", settings.c_str());
         JsonDocument new_settings;
         DeserializationError error = deserializeJson(new_settings, settings);
         if (error) 
         {
-            Serial.println("Bad setting data received");
+            Logger::warning("Bad setting data received");
             return false;
         }
         new_settings.shrinkToFit();
         BotConfig.RobotName = new_settings["name"].as<String>();
-        TunableBotSettings.clear();
+        std::map<String, BotSetting> previous;
+        previous.swap(TunableBotSettings);
+        bool keysChanged = false;
         for (JsonPair kv : new_settings["controls"].as<JsonObject>())
         {
+            keysChanged |= previous.find(kv.key().c_str()) == previous.end();
             TunableBotSettings[kv.key().c_str()] = BotSetting 
             {
                 displayname: kv.value()["displayname"].as<String>(),
@@ -29,59 +42,883 @@ bool Configuration::updateSettings(String settings) {
                 value: kv.value()["value"].as<float>()
             };
         }
+        if (keysChanged || previous.size() != TunableBotSettings.size())
+        {
+            // Patches are saved by setting index, which no longer matches, so the whole record has to be rewritten
+            pendingPatches = 0;
+            recordPending = true;
+            lastChange = millis();
+        }
+        settingsVersion++;
+    }
+    return true;
+}
+
+/// @brief Changes some settings in place, leaving the others untouched.
+/// @param patch A JSON object of setting keys and their new values, e.g. {"drift": 6, "turnAngle": 88.5}.
+/// @return True if every setting was valid and updated.
+bool Configuration::patchSettings(String patch) {
+    JsonDocument changes;
+    if (deserializeJson(changes, patch)) 
+    {
+        Logger::warning("Bad setting patch received");
+        return false;
+    }
+    bool success = true;
+    for (JsonPair kv : changes.as<JsonObject>())
+    {
+        success &= updateSetting(kv.key().c_str(), kv.value().as<float>());
+    }
+    return success;
+}
+
+/// @brief Validates and changes a single setting, scheduling only that setting to be saved.
+/// @param key The setting to change.
+/// @param value The new value, snapped to the setting's increment.
+/// @return True on success.
+bool Configuration::updateSetting(const String& key, float value) {
+    auto setting = TunableBotSettings.find(key);
+    if (setting == TunableBotSettings.end())
+    {
+        Logger::warning("Unknown setting: %s", key.c_str());
+        return false;
+    }
+    BotSetting& current = setting->second;
+    if (value < current.min || value > current.max)
+    {
+        Logger::warning("Setting out of range: %s", key.c_str());
+        return false;
+    }
+    int index = std::distance(TunableBotSettings.begin(), setting);
+    if (index >= MaxSettings)
+    {
+        Logger::warning("Setting can't be saved: %s", key.c_str());
+        return false;
+    }
+    if (current.increment > 0)
+    {
+        value = constrain(current.min + roundf((value - current.min) / current.increment) * current.increment, (float)current.min, (float)current.max);
+    }
+    current.value = value;
+    settingsVersion++;
+    if (recordPending || pendingPatches != 0)
+    {
+        StorageStats.coalesced++;
+    }
+    pendingPatches |= 1UL << index;
+    lastChange = millis();
+    return true;
+}
+
+/// @brief Adds a setting if it's missing, so settings saved by older firmware gain new settings.
+/// @param key The setting key.
+/// @param setting The setting with its default value.
+/// @return True if the setting was added, in which case the settings should be saved.
+bool Configuration::addDefaultSetting(const String& key, BotSetting setting) {
+    if (TunableBotSettings.find(key) != TunableBotSettings.end())
+    {
+        return false;
     }
+    TunableBotSettings[key] = setting;
+    settingsVersion++;
     return true;
 }
 
-/// @brief Saves the current settings to permanent storage like EEPROM or SPIFS.
+/// @brief Schedules the current settings to be saved once changes stop for QuietPeriod.
 /// @return True on success.
 bool Configuration::saveSettings() {
-    // Save values to file
-    String settings = getSettings();
-    Serial.println("Saving config");
-    File configFile = SPIFFS.open("/robot_config.json", "w");
-    if (!configFile) {
-        Serial.println("Failed to open config file for writing");
+    if (recordPending || pendingPatches != 0)
+    {
+        StorageStats.coalesced++;
+    }
+    recordPending = true;
+    settingsVersion++;
+    lastChange = millis();
+    return true;
+}
+
+/// @brief Writes pending settings changes to NVS if there have been no changes for QuietPeriod.
+/// @param force Write pending changes immediately.
+/// @return True on success or if nothing needed writing.
+bool Configuration::flushSettings(bool force) {
+    if ((!recordPending && pendingPatches == 0) || (!force && millis() - lastChange < QuietPeriod))
+    {
+        return true;
+    }
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    unsigned long start = micros();
+    // A full record includes any individually changed settings
+    bool success = recordPending ? writeRecord() : writePatches();
+    StorageStats.lastSaveTime = micros() - start;
+    StorageStats.maxSaveTime = max(StorageStats.maxSaveTime, StorageStats.lastSaveTime);
+    xSemaphoreGive(storageLock);
+    return success;
+}
+
+/// @brief Retrieves the settings storage counters.
+/// @return A JSON string of the storage statistics.
+String Configuration::getStorageStatistics() {
+    char json[200];
+    snprintf(json, sizeof(json), "{\"generation\":%u,\"recordWrites\":%u,\"patchWrites\":%u,\"bytesWritten\":%u,\"coalesced\":%u,\"lastSaveTime\":%u,\"maxSaveTime\":%u}",
+        generation, StorageStats.recordWrites, StorageStats.patchWrites, StorageStats.bytesWritten, StorageStats.coalesced, StorageStats.lastSaveTime, StorageStats.maxSaveTime);
+    return String(json);
+}
+
+/// @brief Writes the current settings as a binary record to the inactive slot, leaving the current record intact until it succeeds.
+/// @return True on success.
+bool Configuration::writeRecord() {
+    Logger::info("Saving config");
+    if (TunableBotSettings.size() > MaxSettings)
+    {
+        Logger::error("Too many settings to save");
         return false;
     }
+    std::unique_ptr<SettingsRecord> record(new SettingsRecord());
+    record->magic = SettingsMagic;
+    record->version = SettingsVersion;
+    record->count = TunableBotSettings.size();
+    record->generation = generation + 1;
+    strncpy(record->name, BotConfig.RobotName.c_str(), sizeof(record->name) - 1);
+    int i = 0;
+    for (auto const& pair : TunableBotSettings)
+    {
+        StoredSetting& stored = record->settings[i++];
+        strncpy(stored.key, pair.first.c_str(), sizeof(stored.key) - 1);
+        strncpy(stored.displayname, pair.second.displayname.c_str(), sizeof(stored.displayname) - 1);
+        stored.min = pair.second.min;
+        stored.max = pair.second.max;
+        stored.increment = pair.second.increment;
+        stored.value = pair.second.value;
+    }
+    record->crc = recordCRC(*record);
+    int slot = 1 - activeSlot;
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    size_t size = recordSize(record->count);
+    bool success = preferences.putBytes(slotKeys[slot], record.get(), size) == size;
+    if (success)
+    {
+        // The new record includes any patched values
+        activeSlot = slot;
+        generation = record->generation;
+        savedCRC = record->crc;
+        recordPending = false;
+        pendingPatches = 0;
+        clearPatches(preferences);
+        if (legacyRecord)
+        {
+            preferences.remove("settings");
+            legacyRecord = false;
+        }
+        StorageStats.recordWrites++;
+        StorageStats.bytesWritten += size;
+    }
     else
     {
-        configFile.print(settings);
-        configFile.close();
-        return true;
+        Logger::error("Failed to write config");
+    }
+    preferences.end();
+    return success;
+}
+
+/// @brief Writes the individually changed settings on top of the current settings record.
+/// @return True on success.
+bool Configuration::writePatches() {
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    bool success = true;
+    int index = 0;
+    for (auto const& pair : TunableBotSettings)
+    {
+        if (pendingPatches & (1UL << index))
+        {
+            char key[8];
+            snprintf(key, sizeof(key), "p%d", index);
+            success &= preferences.putFloat(key, pair.second.value) == sizeof(float);
+            StorageStats.patchWrites++;
+            StorageStats.bytesWritten += sizeof(float);
+        }
+        index++;
+    }
+    if (success)
+    {
+        patchedSettings |= pendingPatches;
+        pendingPatches = 0;
+        PatchIndex patches { savedCRC, patchedSettings };
+        success = preferences.putBytes("patches", &patches, sizeof(PatchIndex)) == sizeof(PatchIndex);
+        StorageStats.bytesWritten += sizeof(PatchIndex);
     }
+    preferences.end();
+    return success;
+}
+
+/// @brief Removes the individually saved settings values.
+/// @param preferences The open preferences to remove them from.
+void Configuration::clearPatches(Preferences& preferences) {
+    if (patchedSettings == 0)
+    {
+        return;
+    }
+    preferences.remove("patches");
+    for (int i = 0; i < MaxSettings; i++)
+    {
+        if (patchedSettings & (1UL << i))
+        {
+            char key[8];
+            snprintf(key, sizeof(key), "p%d", i);
+            preferences.remove(key);
+        }
+    }
+    patchedSettings = 0;
 }
 
 /// @brief Retrieves the current robot settings.
 /// @return A JSON string of all the modifiable movement parameters.
 String Configuration::getSettings() {
-    JsonDocument settings_doc;
-    settings_doc["name"] = BotConfig.RobotName;
-    for (auto const& pair : TunableBotSettings)
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    uint32_t version = settingsVersion;
+    if (cachedVersion != version)
     {
-        settings_doc["controls"][String(pair.first)]["displayname"] = pair.second.displayname;
-        settings_doc["controls"][String(pair.first)]["min"] = pair.second.min;
-        settings_doc["controls"][String(pair.first)]["max"] = pair.second.max;
-        settings_doc["controls"][String(pair.first)]["increment"] = pair.second.increment;
-        settings_doc["controls"][String(pair.first)]["value"] = pair.second.value;
+        JsonDocument settings_doc;
+        settings_doc["name"] = BotConfig.RobotName;
+        JsonObject controls = settings_doc["controls"].to<JsonObject>();
+        for (auto const& pair : TunableBotSettings)
+        {
+            JsonObject control = controls[pair.first].to<JsonObject>();
+            control["displayname"] = pair.second.displayname;
+            control["min"] = pair.second.min;
+            control["max"] = pair.second.max;
+            control["increment"] = pair.second.increment;
+            control["value"] = pair.second.value;
+        }
+        cachedSettings = "";
+        serializeJson(settings_doc, cachedSettings);
+        cachedVersion = version;
     }
-    settings_doc.shrinkToFit();
-    String settings_string;
-    serializeJson(settings_doc, settings_string);
+    String settings_string = cachedSettings;
+    xSemaphoreGive(cacheLock);
     return settings_string;
 }
 
-/// @brief Loads the robot settings from storage like EEPROM or SPIFFS.
+/// @brief Gets a tag that changes whenever the settings change, including across reboots.
+/// @return The boot nonce and settings version, quoted for use as an ETag.
+String Configuration::getSettingsTag() {
+    char tag[24];
+    snprintf(tag, sizeof(tag), "\"%08x-%u\"", bootNonce, settingsVersion);
+    return String(tag);
+}
+
+/// @brief Loads the robot settings from NVS, or imports them from a JSON file saved by older firmware.
 /// @return True on success.
 bool Configuration::loadSettings() {
+    unsigned long start = micros();
+    loadProfiles();
+    loadVelocityTables();
+    loadGyroBiasModel();
+    if (loadRecord())
+    {
+        settingsVersion++;
+        Logger::info("Settings loaded in %luus", micros() - start);
+        return true;
+    }
+    if (importJSON())
+    {
+        Logger::info("Settings imported in %luus", micros() - start);
+        saveSettings();
+        return true;
+    }
+    return false;
+}
+
+/// @brief Saves the current tuning values as a named tuning profile, replacing any profile with the same name.
+/// @param name The profile name.
+/// @return True on success.
+bool Configuration::saveProfile(const String& name) {
+    if (name == "" || name.length() >= sizeof(TuningProfile::name))
+    {
+        Logger::warning("Invalid profile");
+        return false;
+    }
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    int index = findProfile(name);
+    for (int i = 0; i < MaxProfiles && index < 0; i++)
+    {
+        if (profiles[i].crc == 0)
+        {
+            index = i;
+        }
+    }
+    bool success = false;
+    if (index >= 0)
+    {
+        TuningProfile& profile = profiles[index];
+        memset(&profile, 0, sizeof(TuningProfile));
+        strncpy(profile.name, name.c_str(), sizeof(profile.name) - 1);
+        for (auto const& pair : TunableBotSettings)
+        {
+            if (profile.count < MaxSettings && pair.first.length() < sizeof(ProfileValue::key) && isTuningKey(pair.first))
+            {
+                ProfileValue& stored = profile.values[profile.count++];
+                strncpy(stored.key, pair.first.c_str(), sizeof(stored.key) - 1);
+                stored.value = pair.second.value;
+            }
+        }
+        profile.crc = profileCRC(profile);
+        char key[12];
+        snprintf(key, sizeof(key), "profile%d", index);
+        Preferences preferences;
+        preferences.begin("ruckus", false);
+        success = preferences.putBytes(key, &profile, sizeof(TuningProfile)) == sizeof(TuningProfile) &&
+            preferences.putChar("profile", index) == 1;
+        preferences.end();
+        StorageStats.bytesWritten += sizeof(TuningProfile) + 1;
+        activeProfile = index;
+    }
+    else
+    {
+        Logger::warning("No free profile slots");
+    }
+    xSemaphoreGive(storageLock);
+    return success;
+}
+
+/// @brief Applies a named tuning profile to the current settings without parsing or restarting.
+/// Only the tuning values in the profile are changed, values for settings the robot no longer has are skipped.
+/// @param name The profile name.
+/// @return True on success.
+bool Configuration::selectProfile(const String& name) {
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    int index = findProfile(name);
+    if (index < 0)
+    {
+        xSemaphoreGive(storageLock);
+        Logger::warning("Profile not found: %s", name.c_str());
+        return false;
+    }
+    const TuningProfile& profile = profiles[index];
+    int skipped = 0;
+    for (int i = 0; i < profile.count; i++)
+    {
+        auto setting = TunableBotSettings.find(profile.values[i].key);
+        if (setting == TunableBotSettings.end() || !isTuningKey(setting->first))
+        {
+            skipped++;
+            continue;
+        }
+        setting->second.value = constrain(profile.values[i].value, (float)setting->second.min, (float)setting->second.max);
+    }
+    if (skipped > 0)
+    {
+        Logger::warning("Skipped %d unknown settings in profile %s", skipped, name.c_str());
+    }
+    activeProfile = index;
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    preferences.putChar("profile", index);
+    preferences.end();
+    xSemaphoreGive(storageLock);
+    saveSettings();
+    Logger::info("Profile selected: %s", name.c_str());
+    return true;
+}
+
+/// @brief Gets the name of the last profile applied or saved.
+/// @return The profile name, or an empty string if none.
+String Configuration::getActiveProfile() {
+    return activeProfile >= 0 ? String(profiles[activeProfile].name) : String("");
+}
+
+/// @brief Lists the stored tuning profiles.
+/// @return A JSON string of the profile names and the active profile.
+String Configuration::getProfiles() {
+    JsonDocument profiles_doc;
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    profiles_doc["active"] = getActiveProfile();
+    JsonArray names = profiles_doc["profiles"].to<JsonArray>();
+    for (int i = 0; i < MaxProfiles; i++)
+    {
+        if (profiles[i].crc != 0)
+        {
+            names.add(String(profiles[i].name));
+        }
+    }
+    xSemaphoreGive(storageLock);
+    String profiles_string;
+    serializeJson(profiles_doc, profiles_string);
+    return profiles_string;
+}
+
+/// @brief Loads the stored tuning profiles from NVS.
+void Configuration::loadProfiles() {
+    Preferences preferences;
+    preferences.begin("ruckus", true);
+    for (int i = 0; i < MaxProfiles; i++)
+    {
+        char key[12];
+        snprintf(key, sizeof(key), "profile%d", i);
+        if (preferences.getBytes(key, &profiles[i], sizeof(TuningProfile)) != sizeof(TuningProfile) ||
+            profiles[i].count > MaxSettings || profiles[i].crc != profileCRC(profiles[i]))
+        {
+            memset(&profiles[i], 0, sizeof(TuningProfile));
+        }
+        profiles[i].name[sizeof(profiles[i].name) - 1] = 0;
+        for (int j = 0; j < profiles[i].count; j++)
+        {
+            profiles[i].values[j].key[sizeof(ProfileValue::key) - 1] = 0;
+        }
+    }
+    activeProfile = preferences.getChar("profile", -1);
+    if (activeProfile >= MaxProfiles || (activeProfile >= 0 && profiles[activeProfile].crc == 0))
+    {
+        activeProfile = -1;
+    }
+    preferences.end();
+}
+
+/// @brief Finds a stored tuning profile.
+/// @param name The profile name.
+/// @return The profile index, or -1 if not found.
+int Configuration::findProfile(const String& name) {
+    for (int i = 0; i < MaxProfiles; i++)
+    {
+        if (profiles[i].crc != 0 && name == profiles[i].name)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/// @brief Checks if a setting tunes the robot's movement, so belongs in tuning profiles.
+/// @param key The setting key.
+/// @return True if it's a tuning value.
+bool Configuration::isTuningKey(const String& key) {
+    for (const char* untuned : untunedKeys)
+    {
+        if (key == untuned)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Calculates the CRC of a tuning profile.
+/// @param profile The profile.
+/// @return The CRC32 of everything after the CRC field, never 0.
+uint32_t Configuration::profileCRC(const TuningProfile& profile) {
+    uint32_t crc = crc32_le(0, (const uint8_t*)&profile + sizeof(uint32_t), sizeof(TuningProfile) - sizeof(uint32_t));
+    return crc == 0 ? 1 : crc;
+}
+
+/// @brief Saves a wheel's velocity table.
+/// @param wheel The wheel the table belongs to.
+/// @param velocity Wheel velocities in ascending order.
+/// @param pulse Pulse widths in microseconds producing each velocity, in monotonic order.
+/// @param count The number of points, at least 2.
+/// @return True on success.
+bool Configuration::setVelocityTable(Wheels wheel, const float velocity[], const float pulse[], int count) {
+    if (count < 2 || count > VelocityPoints)
+    {
+        Logger::warning("Invalid velocity table");
+        return false;
+    }
+    VelocityTable table;
+    memset(&table, 0, sizeof(VelocityTable));
+    table.count = count;
+    memcpy(table.velocity, velocity, count * sizeof(float));
+    memcpy(table.pulse, pulse, count * sizeof(float));
+    table.crc = velocityTableCRC(table);
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    velocityTables[wheel] = table;
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    bool success = preferences.putBytes(wheel == LeftWheel ? "velocityL" : "velocityR", &table, sizeof(VelocityTable)) == sizeof(VelocityTable);
+    preferences.end();
+    StorageStats.bytesWritten += sizeof(VelocityTable);
+    xSemaphoreGive(storageLock);
+    return success;
+}
+
+/// @brief Checks if both wheels have velocity tables.
+/// @return True if both tables are available.
+bool Configuration::hasVelocityTables() {
+    return velocityTables[LeftWheel].crc != 0 && velocityTables[RightWheel].crc != 0;
+}
+
+/// @brief Finds the pulse width that produces a wheel velocity, clamped to the measured range.
+/// @param wheel The wheel.
+/// @param velocity The desired velocity.
+/// @return The pulse width in microseconds.
+float Configuration::velocityToPulse(Wheels wheel, float velocity) {
+    const VelocityTable& table = velocityTables[wheel];
+    return interpolate(table.velocity, table.pulse, table.count, velocity);
+}
+
+/// @brief Finds the wheel velocity a pulse width produces, clamped to the measured range.
+/// @param wheel The wheel.
+/// @param pulse The pulse width in microseconds.
+/// @return The velocity.
+float Configuration::pulseToVelocity(Wheels wheel, float pulse) {
+    const VelocityTable& table = velocityTables[wheel];
+    return interpolate(table.pulse, table.velocity, table.count, pulse);
+}
+
+/// @brief Retrieves the velocity tables.
+/// @return A JSON string of the velocity and pulse width points of each wheel.
+String Configuration::getVelocityTables() {
+    JsonDocument tables_doc;
+    const char* names[2] = { "left", "right" };
+    for (int wheel = 0; wheel < 2; wheel++)
+    {
+        JsonArray points = tables_doc[names[wheel]].to<JsonArray>();
+        for (int i = 0; i < velocityTables[wheel].count; i++)
+        {
+            JsonObject point = points.add<JsonObject>();
+            point["velocity"] = velocityTables[wheel].velocity[i];
+            point["pulse"] = velocityTables[wheel].pulse[i];
+        }
+    }
+    String tables_string;
+    serializeJson(tables_doc, tables_string);
+    return tables_string;
+}
+
+/// @brief Loads the velocity tables from NVS.
+void Configuration::loadVelocityTables() {
+    Preferences preferences;
+    preferences.begin("ruckus", true);
+    for (int wheel = 0; wheel < 2; wheel++)
+    {
+        VelocityTable& table = velocityTables[wheel];
+        if (preferences.getBytes(wheel == LeftWheel ? "velocityL" : "velocityR", &table, sizeof(VelocityTable)) != sizeof(VelocityTable) ||
+            table.count < 2 || table.count > VelocityPoints || table.crc != velocityTableCRC(table))
+        {
+            memset(&table, 0, sizeof(VelocityTable));
+        }
+    }
+    preferences.end();
+}
+
+/// @brief Calculates the CRC of a velocity table.
+/// @param table The table.
+/// @return The CRC32 of everything after the CRC field, never 0.
+uint32_t Configuration::velocityTableCRC(const VelocityTable& table) {
+    uint32_t crc = crc32_le(0, (const uint8_t*)&table + sizeof(uint32_t), sizeof(VelocityTable) - sizeof(uint32_t));
+    return crc == 0 ? 1 : crc;
+}
+
+/// @brief Saves the gyro offsets so they can be reused on the next boot.
+/// @param offsets The X, Y and Z offsets in degrees per second.
+/// @param temperature The sensor temperature they were measured at in degrees Celsius.
+/// @return True on success.
+bool Configuration::setGyroCalibration(const float offsets[3], float temperature) {
+    GyroCalibration calibration;
+    memcpy(calibration.offsets, offsets, sizeof(calibration.offsets));
+    calibration.temperature = temperature;
+    calibration.crc = gyroCalibrationCRC(calibration);
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    bool success = preferences.putBytes("gyroCal", &calibration, sizeof(GyroCalibration)) == sizeof(GyroCalibration);
+    preferences.end();
+    StorageStats.bytesWritten += sizeof(GyroCalibration);
+    xSemaphoreGive(storageLock);
+    return success;
+}
+
+/// @brief Reads the saved gyro offsets. Doesn't need the settings to be loaded.
+/// @param offsets Receives the X, Y and Z offsets in degrees per second.
+/// @param temperature Receives the sensor temperature they were measured at in degrees Celsius.
+/// @return True if valid offsets were saved.
+bool Configuration::getGyroCalibration(float offsets[3], float& temperature) {
+    GyroCalibration calibration;
+    Preferences preferences;
+    preferences.begin("ruckus", true);
+    bool valid = preferences.getBytes("gyroCal", &calibration, sizeof(GyroCalibration)) == sizeof(GyroCalibration) &&
+        calibration.crc == gyroCalibrationCRC(calibration);
+    preferences.end();
+    if (valid)
+    {
+        memcpy(offsets, calibration.offsets, sizeof(calibration.offsets));
+        temperature = calibration.temperature;
+    }
+    return valid;
+}
+
+/// @brief Calculates the CRC of a gyro calibration.
+/// @param calibration The calibration.
+/// @return The CRC32 of everything after the CRC field.
+uint32_t Configuration::gyroCalibrationCRC(const GyroCalibration& calibration) {
+    return crc32_le(0, (const uint8_t*)&calibration + sizeof(uint32_t), sizeof(GyroCalibration) - sizeof(uint32_t));
+}
+
+/// @brief Adds a gyro bias measurement to the temperature model and saves it.
+/// A sample close in temperature to an existing one replaces it, and once full the closest sample is replaced, keeping the widest spread.
+/// @param temperature The sensor temperature in degrees Celsius.
+/// @param bias The X axis bias in degrees per second.
+/// @return True on success.
+bool Configuration::addGyroBiasSample(float temperature, float bias) {
+    xSemaphoreTake(storageLock, portMAX_DELAY);
+    int closest = -1;
+    for (int i = 0; i < biasModel.count; i++)
+    {
+        if (closest < 0 || abs(biasModel.temperature[i] - temperature) < abs(biasModel.temperature[closest] - temperature))
+        {
+            closest = i;
+        }
+    }
+    int index = biasModel.count;
+    if (closest >= 0 && (abs(biasModel.temperature[closest] - temperature) < BiasSampleSpacing || biasModel.count == BiasSamples))
+    {
+        index = closest;
+    }
+    else
+    {
+        biasModel.count++;
+    }
+    biasModel.temperature[index] = temperature;
+    biasModel.bias[index] = bias;
+    biasModel.crc = gyroBiasModelCRC(biasModel);
+    fitGyroBiasModel();
+    Preferences preferences;
+    preferences.begin("ruckus", false);
+    bool success = preferences.putBytes("gyroBias", &biasModel, sizeof(GyroBiasModel)) == sizeof(GyroBiasModel);
+    preferences.end();
+    StorageStats.bytesWritten += sizeof(GyroBiasModel);
+    xSemaphoreGive(storageLock);
+    return success;
+}
+
+/// @brief Checks if there are enough bias samples to correct the gyro.
+/// @return True if the model can be used.
+bool Configuration::hasGyroBiasModel() {
+    return biasModel.count >= 2 && biasMaxTemperature - biasMinTemperature >= MinBiasSpread;
+}
+
+/// @brief Predicts the X axis gyro bias at a temperature. Only meaningful if hasGyroBiasModel() is true.
+/// @param temperature The sensor temperature in degrees Celsius.
+/// @return The bias in degrees per second.
+float Configuration::gyroBias(float temperature) {
+    temperature = constrain(temperature, biasMinTemperature - BiasExtrapolation, biasMaxTemperature + BiasExtrapolation);
+    return biasMean + biasSlope * (temperature - biasMeanTemperature);
+}
+
+/// @brief Retrieves the gyro bias model.
+/// @return A JSON string of the samples and the fitted line.
+String Configuration::getGyroBiasModel() {
+    JsonDocument model_doc;
+    JsonArray samples = model_doc["samples"].to<JsonArray>();
+    for (int i = 0; i < biasModel.count; i++)
+    {
+        JsonObject sample = samples.add<JsonObject>();
+        sample["temperature"] = biasModel.temperature[i];
+        sample["bias"] = biasModel.bias[i];
+    }
+    model_doc["active"] = hasGyroBiasModel();
+    model_doc["slope"] = biasSlope;
+    model_doc["temperature"] = biasMeanTemperature;
+    model_doc["bias"] = biasMean;
+    String model_string;
+    serializeJson(model_doc, model_string);
+    return model_string;
+}
+
+/// @brief Loads the gyro bias model from NVS.
+void Configuration::loadGyroBiasModel() {
+    Preferences preferences;
+    preferences.begin("ruckus", true);
+    if (preferences.getBytes("gyroBias", &biasModel, sizeof(GyroBiasModel)) != sizeof(GyroBiasModel) ||
+        biasModel.count > BiasSamples || biasModel.crc != gyroBiasModelCRC(biasModel))
+    {
+        memset(&biasModel, 0, sizeof(GyroBiasModel));
+    }
+    preferences.end();
+    fitGyroBiasModel();
+}
+
+/// @brief Fits a least squares line through the bias samples.
+void Configuration::fitGyroBiasModel() {
+    float sumTemperature = 0;
+    float sumBias = 0;
+    biasMinTemperature = biasModel.count > 0 ? biasModel.temperature[0] : 0;
+    biasMaxTemperature = biasMinTemperature;
+    for (int i = 0; i < biasModel.count; i++)
+    {
+        sumTemperature += biasModel.temperature[i];
+        sumBias += biasModel.bias[i];
+        biasMinTemperature = min(biasMinTemperature, biasModel.temperature[i]);
+        biasMaxTemperature = max(biasMaxTemperature, biasModel.temperature[i]);
+    }
+    float meanTemperature = biasModel.count > 0 ? sumTemperature / biasModel.count : 0;
+    float mean = biasModel.count > 0 ? sumBias / biasModel.count : 0;
+    float covariance = 0;
+    float variance = 0;
+    for (int i = 0; i < biasModel.count; i++)
+    {
+        covariance += (biasModel.temperature[i] - meanTemperature) * (biasModel.bias[i] - mean);
+        variance += (biasModel.temperature[i] - meanTemperature) * (biasModel.temperature[i] - meanTemperature);
+    }
+    biasSlope = variance > 0 ? covariance / variance : 0;
+    biasMeanTemperature = meanTemperature;
+    biasMean = mean;
+}
+
+/// @brief Calculates the CRC of a gyro bias model.
+/// @param model The model.
+/// @return The CRC32 of everything after the CRC field.
+uint32_t Configuration::gyroBiasModelCRC(const GyroBiasModel& model) {
+    return crc32_le(0, (const uint8_t*)&model + sizeof(uint32_t), sizeof(GyroBiasModel) - sizeof(uint32_t));
+}
+
+/// @brief Linearly interpolates between points, clamping to the end points.
+/// @param x The x values, in ascending or descending order.
+/// @param y The y values.
+/// @param count The number of points, at least 2.
+/// @param value The x value to look up.
+/// @return The interpolated y value.
+float Configuration::interpolate(const float x[], const float y[], int count, float value) {
+    // Flip the comparison for descending tables
+    float direction = x[count - 1] >= x[0] ? 1 : -1;
+    if ((value - x[0]) * direction <= 0)
+    {
+        return y[0];
+    }
+    for (int i = 1; i < count; i++)
+    {
+        if ((value - x[i]) * direction <= 0)
+        {
+            return y[i - 1] + (y[i] - y[i - 1]) * (value - x[i - 1]) / (x[i] - x[i - 1]);
+        }
+    }
+    return y[count - 1];
+}
+
+/// @brief Gets the stored size of a settings record.
+/// @param count The number of settings in the record.
+/// @return The size in bytes.
+size_t Configuration::recordSize(uint16_t count) {
+    return offsetof(SettingsRecord, settings) + count * sizeof(StoredSetting);
+}
+
+/// @brief Calculates the CRC of a settings record.
+/// @param record The record, its count must be valid.
+/// @return The CRC32 of everything after the CRC field.
+uint32_t Configuration::recordCRC(const SettingsRecord& record) {
+    size_t start = offsetof(SettingsRecord, generation);
+    return crc32_le(0, (const uint8_t*)&record + start, recordSize(record.count) - start);
+}
+
+/// @brief Reads and validates a settings record slot.
+/// @param preferences The open preferences to read from.
+/// @param slot The slot to read.
+/// @param record Receives the record.
+/// @return True if the slot holds a valid record.
+bool Configuration::readSlot(Preferences& preferences, int slot, SettingsRecord& record) {
+    size_t size = preferences.getBytes(slotKeys[slot], &record, sizeof(SettingsRecord));
+    return size >= recordSize(0) && record.magic == SettingsMagic && record.version == SettingsVersion &&
+        record.count <= MaxSettings && size == recordSize(record.count) && record.crc == recordCRC(record);
+}
+
+/// @brief Reads and validates a version 1 settings record, converting it to the current layout.
+/// @param preferences The open preferences to read from.
+/// @param record Receives the converted record.
+/// @return True if a valid version 1 record was found.
+bool Configuration::readLegacyRecord(Preferences& preferences, SettingsRecord& record) {
+    std::unique_ptr<LegacySettingsRecord> legacy(new LegacySettingsRecord());
+    size_t size = preferences.getBytes("settings", legacy.get(), sizeof(LegacySettingsRecord));
+    size_t header = offsetof(LegacySettingsRecord, settings);
+    if (size < header || legacy->magic != SettingsMagic || legacy->version != 1 || legacy->count > MaxSettings ||
+        size != header + legacy->count * sizeof(StoredSetting))
+    {
+        return false;
+    }
+    size_t start = offsetof(LegacySettingsRecord, name);
+    if (legacy->crc != crc32_le(0, (const uint8_t*)legacy.get() + start, size - start))
+    {
+        return false;
+    }
+    record.magic = SettingsMagic;
+    record.version = SettingsVersion;
+    record.count = legacy->count;
+    record.generation = 0;
+    memcpy(record.name, legacy->name, sizeof(record.name));
+    memcpy(record.settings, legacy->settings, legacy->count * sizeof(StoredSetting));
+    // Keep the old CRC so settings patched on top of the old record still apply
+    record.crc = legacy->crc;
+    return true;
+}
+
+/// @brief Loads the robot settings from the newest valid binary record in NVS.
+/// @return True on success.
+bool Configuration::loadRecord() {
+    std::unique_ptr<SettingsRecord> slots[2] = { std::unique_ptr<SettingsRecord>(new SettingsRecord()), std::unique_ptr<SettingsRecord>(new SettingsRecord()) };
+    Preferences preferences;
+    preferences.begin("ruckus", true);
+    bool valid[2] = { readSlot(preferences, 0, *slots[0]), readSlot(preferences, 1, *slots[1]) };
+    if (!valid[0] && !valid[1])
+    {
+        if (!readLegacyRecord(preferences, *slots[0]))
+        {
+            preferences.end();
+            Logger::info("No valid settings record found");
+            return false;
+        }
+        // Rewrite the migrated settings in the current layout
+        valid[0] = true;
+        legacyRecord = true;
+        recordPending = true;
+    }
+    // An interrupted write leaves the other slot holding the previous record
+    activeSlot = !valid[0] || (valid[1] && slots[1]->generation > slots[0]->generation) ? 1 : 0;
+    SettingsRecord* record = slots[activeSlot].get();
+    generation = record->generation;
+    savedCRC = record->crc;
+    // Apply settings saved individually since the record was written
+    PatchIndex patches { 0, 0 };
+    preferences.getBytes("patches", &patches, sizeof(PatchIndex));
+    patchedSettings = patches.recordCRC == savedCRC ? patches.patched : 0;
+    for (int i = 0; i < record->count; i++)
+    {
+        if (patchedSettings & (1UL << i))
+        {
+            char key[8];
+            snprintf(key, sizeof(key), "p%d", i);
+            record->settings[i].value = preferences.getFloat(key, record->settings[i].value);
+        }
+    }
+    preferences.end();
+    record->name[sizeof(record->name) - 1] = 0;
+    BotConfig.RobotName = record->name;
+    TunableBotSettings.clear();
+    for (int i = 0; i < record->count; i++)
+    {
+        StoredSetting& stored = record->settings[i];
+        stored.key[sizeof(stored.key) - 1] = 0;
+        stored.displayname[sizeof(stored.displayname) - 1] = 0;
+        TunableBotSettings[stored.key] = BotSetting
+        {
+            displayname: stored.displayname,
+            min: stored.min,
+            max: stored.max,
+            increment: stored.increment,
+            value: stored.value
+        };
+    }
+    return true;
+}
+
+/// @brief Imports the robot settings from the JSON file in SPIFFS used by older firmware.
+/// @return True on success.
+bool Configuration::importJSON() {
     if (SPIFFS.exists("/robot_config.json")) 
     {
         // File exists, reading and loading
-        Serial.println("Opening robot config file");
+        Logger::info("Opening robot config file");
         File configFile = SPIFFS.open("/robot_config.json", "r");
         if (configFile) 
         {
-            Serial.println("Reading robot config file, loading settings...");
+            Logger::info("Reading robot config file, loading settings...");
             String settings = "";
             // Read file
             while(configFile.available())
@@ -89,18 +926,18 @@ bool Configuration::loadSettings() {
                 settings += configFile.readString();
             }
             configFile.close();
-            Serial.println("Settings loaded");
+            Logger::info("Settings loaded");
             // Apply loaded settings
             return updateSettings(settings);            
         } 
         else 
         {
-            Serial.println("Robot config file could not be opened");
+            Logger::error("Robot config file could not be opened");
         }
     }
     else 
     {
-        Serial.println("Robot config file not found");
+        Logger::warning("Robot config file not found");
     }
     return false;
 }
\ No newline at end of file
@@ -11,7 +11,12 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <SPIFFS.h>
+#include <Preferences.h>
+#include <esp_system.h>
+#include <esp32/rom/crc.h>
 #include <map>
+#include <memory>
+#include <Logger.h>
 
 class Configuration 
 {
@@ -56,9 +61,277 @@ class Configuration
         /// @brief A collection of tunable robot settings.
         std::map<String, BotSetting> TunableBotSettings;
 
+        /// @brief The robot's wheels.
+        enum Wheels { LeftWheel, RightWheel };
+
+        /// @brief Number of points in a wheel velocity table.
+        static const int VelocityPoints = 16;
+
+        /// @brief Number of temperature samples kept for the gyro bias model.
+        static const int BiasSamples = 8;
+
+        /// @brief Counters describing how settings have been written to flash.
+        struct StorageStatistics
+        {
+            /// @brief Full settings records written.
+            uint32_t recordWrites;
+            /// @brief Individual setting values written.
+            uint32_t patchWrites;
+            /// @brief Total bytes written.
+            uint32_t bytesWritten;
+            /// @brief Save requests merged into a later write.
+            uint32_t coalesced;
+            /// @brief Duration of the last write in microseconds.
+            uint32_t lastSaveTime;
+            /// @brief Longest write in microseconds.
+            uint32_t maxSaveTime;
+        };
+
+        /// @brief Counters describing how settings have been written to flash.
+        StorageStatistics StorageStats = { 0, 0, 0, 0, 0, 0 };
+
         // Public methods
+        Configuration();
         bool updateSettings(String settings);
+        bool patchSettings(String patch);
+        bool updateSetting(const String& key, float value);
+        bool addDefaultSetting(const String& key, BotSetting setting);
         String getSettings();
+        String getSettingsTag();
         bool loadSettings();
         bool saveSettings();
+        bool flushSettings(bool force = false);
+        String getStorageStatistics();
+        bool saveProfile(const String& name);
+        bool selectProfile(const String& name);
+        String getActiveProfile();
+        String getProfiles();
+        bool setVelocityTable(Wheels wheel, const float velocity[], const float pulse[], int count);
+        bool hasVelocityTables();
+        float velocityToPulse(Wheels wheel, float velocity);
+        float pulseToVelocity(Wheels wheel, float pulse);
+        String getVelocityTables();
+        bool setGyroCalibration(const float offsets[3], float temperature);
+        bool getGyroCalibration(float offsets[3], float& temperature);
+        bool addGyroBiasSample(float temperature, float bias);
+        bool hasGyroBiasModel();
+        float gyroBias(float temperature);
+        String getGyroBiasModel();
+
+    private:
+        /// @brief Identifies a stored settings record.
+        static const uint32_t SettingsMagic = 0x52554B53;
+
+        /// @brief Layout version of the stored settings record, increment when it changes.
+        static const uint16_t SettingsVersion = 2;
+
+        /// @brief Time without changes before pending settings are written, in milliseconds.
+        static const unsigned long QuietPeriod = 2000;
+
+        /// @brief NVS keys of the two record slots, written alternately.
+        const char* slotKeys[2] = { "settingsA", "settingsB" };
+
+        /// @brief Maximum number of tunable settings that can be stored.
+        static const uint16_t MaxSettings = 24;
+
+        /// @brief A tunable setting as stored in NVS.
+        struct __attribute__((packed)) StoredSetting
+        {
+            char key[24];
+            char displayname[32];
+            int32_t min;
+            int32_t max;
+            float increment;
+            float value;
+        };
+
+        /// @brief All robot settings as stored in NVS. Only the used settings entries are stored.
+        struct __attribute__((packed)) SettingsRecord
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t count;
+            /// @brief CRC32 of everything after this field
+            uint32_t crc;
+            /// @brief Incremented on every write, the slot with the highest valid generation is current
+            uint32_t generation;
+            char name[32];
+            StoredSetting settings[MaxSettings];
+        };
+
+        /// @brief A settings record as stored by firmware before records had a generation, version 1.
+        struct __attribute__((packed)) LegacySettingsRecord
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t count;
+            /// @brief CRC32 of everything after this field
+            uint32_t crc;
+            char name[32];
+            StoredSetting settings[MaxSettings];
+        };
+
+        /// @brief Lists the settings saved individually on top of a settings record.
+        struct __attribute__((packed)) PatchIndex
+        {
+            /// @brief CRC of the record the patches apply to, so they're ignored once it's replaced
+            uint32_t recordCRC;
+            /// @brief Bit mask of the patched setting indices
+            uint32_t patched;
+        };
+
+        /// @brief Maximum number of tuning profiles that can be stored.
+        static const int MaxProfiles = 4;
+
+        /// @brief Settings that describe the robot rather than tune its movement, never saved in or applied from a profile.
+        const char* untunedKeys[3] = { "robotColor", "batteryPin", "batteryDivider" };
+
+        /// @brief A setting value in a tuning profile.
+        struct __attribute__((packed)) ProfileValue
+        {
+            char key[24];
+            float value;
+        };
+
+        /// @brief A named set of setting values, stored in NVS and kept in memory ready to apply.
+        struct __attribute__((packed)) TuningProfile
+        {
+            /// @brief CRC32 of everything after this field, 0 if the profile slot is empty
+            uint32_t crc;
+            uint16_t count;
+            uint16_t reserved;
+            char name[16];
+            /// @brief The tuning values by key, so settings added or removed since don't affect the others
+            ProfileValue values[MaxSettings];
+        };
+
+        /// @brief The stored tuning profiles.
+        TuningProfile profiles[MaxProfiles];
+
+        /// @brief Index of the last profile applied or saved, -1 if none.
+        int activeProfile = -1;
+
+        /// @brief Maps a wheel's velocity to the servo pulse width producing it, measured on the robot.
+        struct VelocityTable
+        {
+            /// @brief CRC32 of everything after this field, 0 if the table is empty
+            uint32_t crc;
+            uint16_t count;
+            uint16_t reserved;
+            /// @brief Wheel velocities in ascending order, as the yaw rate in degrees per second of the robot pivoting on the other wheel, positive forward
+            float velocity[VelocityPoints];
+            /// @brief Pulse widths in microseconds, monotonic
+            float pulse[VelocityPoints];
+        };
+
+        /// @brief The velocity table of each wheel.
+        VelocityTable velocityTables[2];
+
+        /// @brief Gyro offsets measured on the robot and the temperature they were measured at.
+        struct GyroCalibration
+        {
+            /// @brief CRC32 of everything after this field
+            uint32_t crc;
+            /// @brief X, Y and Z offsets in degrees per second
+            float offsets[3];
+            /// @brief Sensor temperature in degrees Celsius
+            float temperature;
+        };
+
+        /// @brief Heading axis gyro bias measured at different temperatures, fitted with a line to correct the bias as the robot warms up.
+        struct GyroBiasModel
+        {
+            /// @brief CRC32 of everything after this field
+            uint32_t crc;
+            uint16_t count;
+            uint16_t reserved;
+            /// @brief Sensor temperatures in degrees Celsius
+            float temperature[BiasSamples];
+            /// @brief X axis bias in degrees per second at each temperature
+            float bias[BiasSamples];
+        };
+
+        /// @brief Samples within this many degrees Celsius replace each other.
+        static constexpr float BiasSampleSpacing = 1;
+
+        /// @brief Smallest temperature spread in degrees Celsius the bias slope is fitted over.
+        static constexpr float MinBiasSpread = 3;
+
+        /// @brief How far in degrees Celsius the model is extrapolated beyond its samples.
+        static constexpr float BiasExtrapolation = 5;
+
+        /// @brief The gyro bias samples.
+        GyroBiasModel biasModel;
+
+        /// @brief Fitted bias line, slope in degrees per second per degree Celsius through the mean sample.
+        float biasSlope = 0;
+        float biasMeanTemperature = 0;
+        float biasMean = 0;
+
+        /// @brief Temperature range of the bias samples.
+        float biasMinTemperature = 0;
+        float biasMaxTemperature = 0;
+
+        /// @brief CRC of the settings record currently in NVS.
+        uint32_t savedCRC = 0;
+
+        /// @brief Bit mask of the settings saved individually since the record was written.
+        uint32_t patchedSettings = 0;
+
+        /// @brief Slot holding the current settings record.
+        int activeSlot = 1;
+
+        /// @brief Generation of the current settings record.
+        uint32_t generation = 0;
+
+        /// @brief True if the settings were migrated from a legacy record, which is removed once they're rewritten.
+        bool legacyRecord = false;
+
+        /// @brief True if a full record needs to be written.
+        bool recordPending = false;
+
+        /// @brief Bit mask of settings changed individually and not yet written.
+        uint32_t pendingPatches = 0;
+
+        /// @brief Time of the last unsaved change.
+        unsigned long lastChange = 0;
+
+        /// @brief Serializes writes to NVS.
+        SemaphoreHandle_t storageLock;
+
+        /// @brief Incremented whenever the settings change.
+        volatile uint32_t settingsVersion = 1;
+
+        /// @brief Random number chosen at boot, so settings tags from before a reboot never match.
+        uint32_t bootNonce;
+
+        /// @brief Settings JSON serialized for cachedVersion.
+        String cachedSettings;
+
+        /// @brief Settings version cachedSettings was serialized from, 0 if none.
+        uint32_t cachedVersion = 0;
+
+        /// @brief Guards cachedSettings.
+        SemaphoreHandle_t cacheLock;
+
+        size_t recordSize(uint16_t count);
+        bool readSlot(Preferences& preferences, int slot, SettingsRecord& record);
+        bool readLegacyRecord(Preferences& preferences, SettingsRecord& record);
+        bool writeRecord();
+        bool writePatches();
+        void clearPatches(Preferences& preferences);
+        uint32_t recordCRC(const SettingsRecord& record);
+        bool loadRecord();
+        bool importJSON();
+        void loadProfiles();
+        int findProfile(const String& name);
+        bool isTuningKey(const String& key);
+        uint32_t profileCRC(const TuningProfile& profile);
+        void loadVelocityTables();
+        uint32_t velocityTableCRC(const VelocityTable& table);
+        uint32_t gyroCalibrationCRC(const GyroCalibration& calibration);
+        void loadGyroBiasModel();
+        void fitGyroBiasModel();
+        uint32_t gyroBiasModelCRC(const GyroBiasModel& model);
+        static float interpolate(const float x[], const float y[], int count, float value);
 };
@@ -0,0 +1,431 @@
+#include "FirmwareUpdater.h"
+
+/// @brief Creates a firmware updater.
+FirmwareUpdater::FirmwareUpdater()
+{
+    fullBlocks = xQueueCreate(BufferCount + 1, sizeof(Block));
+    freeBlocks = xQueueCreate(BufferCount, sizeof(int));
+    clientLock = xSemaphoreCreateMutex();
+}
+
+/// @brief Starts an update.
+/// @param expectedHash The SHA-256 of the image as a hex string, or empty to skip verification.
+/// @param requester The request uploading the image, the only one allowed to write to and end the update.
+/// @param client The connection the image is received on, paused when flash writes fall behind.
+/// @return True on success, false if the update couldn't start or another is in progress.
+bool FirmwareUpdater::begin(const String& expectedHash, const void* requester, AsyncClient* client)
+{
+    if (running)
+    {
+        Logger::warning("Update already in progress");
+        return false;
+    }
+    owner = requester;
+    Stats = { 0, 0, false, 0, 0, "", false, false };
+    failed = false;
+    checkHash = expectedHash.length() == 64;
+    for (int i = 0; i < 32 && checkHash; i++)
+    {
+        char byte[3] = { expectedHash[i * 2], expectedHash[i * 2 + 1], 0 };
+        char* end;
+        expected[i] = strtoul(byte, &end, 16);
+        checkHash = *end == 0;
+    }
+    if (expectedHash.length() > 0 && !checkHash)
+    {
+        Logger::warning("Ignoring malformed expected SHA-256");
+    }
+
+    // Ensure firmware will fit into flash space
+    if (!Update.begin((ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000))
+    {
+        Logger::error("Update error: %s", Update.errorString());
+        return false;
+    }
+    xQueueReset(fullBlocks);
+    xQueueReset(freeBlocks);
+    for (int i = 0; i < BufferCount; i++)
+    {
+        buffers[i] = (uint8_t*)malloc(SectorSize);
+        if (buffers[i] == NULL)
+        {
+            Logger::error("Not enough memory for update buffers");
+            release();
+            Update.abort();
+            return false;
+        }
+        xQueueSend(freeBlocks, &i, 0);
+    }
+    this->client = client;
+    paused = false;
+    stopping = false;
+    active = -1;
+    fill = 0;
+    inflated = false;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    running = true;
+    startTime = millis();
+    xTaskCreate(FirmwareUpdater::WriterTaskWrapper, "Firmware Writer", 4096, this, 2, NULL);
+    return true;
+}
+
+/// @brief Adds received image data without waiting for flash writes.
+/// When few buffers are left free the data is left unacknowledged, so the client stops sending until the writer catches up.
+/// @param requester The request the data came from.
+/// @param data The data received.
+/// @param len The length of the data.
+/// @return True on success, false on an error or if another request owns the update.
+bool FirmwareUpdater::write(const void* requester, const uint8_t* data, size_t len)
+{
+    if (requester != owner || stopping)
+    {
+        return false;
+    }
+    while (running && !failed && len > 0)
+    {
+        if (active < 0 && xQueueReceive(freeBlocks, &active, 0) != pdTRUE)
+        {
+            // Only happens if the client sends more than its window while paused
+            Logger::error("Update buffers overrun");
+            failed = true;
+            break;
+        }
+        size_t chunk = min(len, SectorSize - fill);
+        memcpy(buffers[active] + fill, data, chunk);
+        fill += chunk;
+        data += chunk;
+        len -= chunk;
+        if (fill == SectorSize)
+        {
+            queueActive();
+        }
+    }
+    size_t space = uxQueueMessagesWaiting(freeBlocks) * SectorSize + (active >= 0 ? SectorSize - fill : 0);
+    if (space < ReserveSpace)
+    {
+        paused = true;
+    }
+    if (paused && client != NULL)
+    {
+        client->ackLater();
+    }
+    return running && !failed;
+}
+
+/// @brief Hands the rest of the image to the writer task, which commits it if it was written and verified.
+/// @param requester The request the image came from.
+/// @return True if the update is being finished, the result is known once inProgress() is false.
+bool FirmwareUpdater::end(const void* requester)
+{
+    if (!running || stopping || requester != owner)
+    {
+        return false;
+    }
+    // Write the partial last sector first
+    if (fill > 0 && !failed)
+    {
+        queueActive();
+    }
+    stopWriter(FinishUpdate);
+    return true;
+}
+
+/// @brief Abandons an update without committing it, e.g. when its upload is cut off.
+/// @param requester The request the image came from, other requests are ignored.
+void FirmwareUpdater::abort(const void* requester)
+{
+    if (!running || stopping || requester != owner)
+    {
+        return;
+    }
+    stopWriter(AbortUpdate);
+}
+
+/// @brief Checks if a request started the current or last update.
+/// @param requester The request.
+/// @return True if it did, false if it was refused because another update was in progress.
+bool FirmwareUpdater::startedBy(const void* requester)
+{
+    return requester == owner;
+}
+
+/// @brief Checks if an update is being received or finished.
+/// @return True until the writer task has committed or abandoned the update.
+bool FirmwareUpdater::inProgress()
+{
+    return running;
+}
+
+/// @brief Checks if the current or last update failed.
+/// @return True if there was an error.
+bool FirmwareUpdater::hasError()
+{
+    return running ? failed : !Stats.success;
+}
+
+/// @brief Gets the results of the last update.
+/// @return A JSON string of the update statistics.
+String FirmwareUpdater::getStatistics()
+{
+    char json[256];
+    snprintf(json, sizeof(json), "{\"running\":%s,\"success\":%s,\"verified\":%s,\"compressed\":%s,\"bytes\":%u,\"received\":%u,\"duration\":%u,\"throughput\":%u,\"sha256\":\"%s\"}",
+        running ? "true" : "false", Stats.success ? "true" : "false", Stats.verified ? "true" : "false", Stats.compressed ? "true" : "false", Stats.bytes, Stats.received, Stats.duration, Stats.throughput, Stats.hash);
+    return String(json);
+}
+
+/// @brief Hands the buffer being filled to the writer task, the next one is taken when data arrives.
+void FirmwareUpdater::queueActive()
+{
+    // The queue has room for every buffer, so this never waits
+    Block block { active, fill };
+    xQueueSend(fullBlocks, &block, 0);
+    active = -1;
+    fill = 0;
+}
+
+/// @brief Tells the writer task to stop once it has written the buffers already queued, without waiting for it.
+/// @param command FinishUpdate or AbortUpdate.
+void FirmwareUpdater::stopWriter(int command)
+{
+    stopping = true;
+    // No more data will be acknowledged, and the connection may close before the writer stops
+    xSemaphoreTake(clientLock, portMAX_DELAY);
+    client = NULL;
+    xSemaphoreGive(clientLock);
+    Block stop { command, 0 };
+    xQueueSend(fullBlocks, &stop, 0);
+}
+
+/// @brief Acknowledges the data held back from a paused client once enough buffers are free again.
+void FirmwareUpdater::resume()
+{
+    if (!paused || uxQueueMessagesWaiting(freeBlocks) * SectorSize < ReserveSpace)
+    {
+        return;
+    }
+    xSemaphoreTake(clientLock, portMAX_DELAY);
+    paused = false;
+    if (client != NULL)
+    {
+        client->ack(SIZE_MAX);
+    }
+    xSemaphoreGive(clientLock);
+}
+
+/// @brief Verifies and commits the image once all of it is written.
+void FirmwareUpdater::finish()
+{
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&sha, hash);
+    mbedtls_sha256_free(&sha);
+    for (int i = 0; i < 32; i++)
+    {
+        sprintf(Stats.hash + i * 2, "%02x", hash[i]);
+    }
+    Stats.duration = millis() - startTime;
+    Stats.throughput = Stats.duration > 0 ? (uint64_t)Stats.received * 1000 / Stats.duration : 0;
+
+    if (failed || Update.hasError())
+    {
+        Logger::error("Update error: %s", Update.errorString());
+        Update.abort();
+    }
+    else if (Stats.compressed && !inflated)
+    {
+        Logger::error("Update compressed image truncated");
+        Update.abort();
+    }
+    else if (checkHash && memcmp(hash, expected, 32) != 0)
+    {
+        Logger::error("Update SHA-256 mismatch: %s", Stats.hash);
+        Update.abort();
+    }
+    else if (Update.end(true))
+    {
+        Stats.verified = checkHash;
+        Stats.success = true;
+    }
+    else
+    {
+        Logger::error("Update error: %s", Update.errorString());
+    }
+    Logger::info("Update %s: %uB written, %uB received%s in %ums (%uB/s)", Stats.success ? "Success" : "Failed", Stats.bytes, Stats.received, Stats.compressed ? " compressed" : "", Stats.duration, Stats.throughput);
+    Logger::info("Update SHA-256 %s%s", Stats.hash, Stats.verified ? " verified" : "");
+    release();
+    running = false;
+}
+
+/// @brief Abandons the image written so far.
+void FirmwareUpdater::discard()
+{
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&sha, hash);
+    mbedtls_sha256_free(&sha);
+    Update.abort();
+    Logger::warning("Update aborted");
+    release();
+    running = false;
+}
+
+/// @brief Frees the update buffers.
+void FirmwareUpdater::release()
+{
+    for (int i = 0; i < BufferCount; i++)
+    {
+        free(buffers[i]);
+        buffers[i] = NULL;
+    }
+    free(inflator);
+    free(window);
+    inflator = NULL;
+    window = NULL;
+}
+
+/// @brief Hashes and writes image data to flash.
+/// @param data The image data.
+/// @param len The length of the data.
+/// @return True on success.
+bool FirmwareUpdater::store(uint8_t* data, size_t len)
+{
+    mbedtls_sha256_update(&sha, data, len);
+    Stats.bytes += len;
+    return Update.write(data, len) == len;
+}
+
+/// @brief Decompresses part of a deflate stream and writes the output.
+/// @param data The compressed data.
+/// @param len The length of the data.
+/// @return True on success.
+bool FirmwareUpdater::inflate(const uint8_t* data, size_t len)
+{
+    // Anything after the end of the stream is the gzip trailer
+    while (!inflated)
+    {
+        size_t in = len;
+        size_t out = TINFL_LZ_DICT_SIZE - windowOffset;
+        tinfl_status status = tinfl_decompress(inflator, data, &in, window, window + windowOffset, &out, TINFL_FLAG_HAS_MORE_INPUT);
+        data += in;
+        len -= in;
+        if (out > 0 && !store(window + windowOffset, out))
+        {
+            return false;
+        }
+        windowOffset = (windowOffset + out) & (TINFL_LZ_DICT_SIZE - 1);
+        if (status < TINFL_STATUS_DONE)
+        {
+            Logger::error("Update decompression failed: %d", status);
+            return false;
+        }
+        inflated = status == TINFL_STATUS_DONE;
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+/// @brief Finds the start of the deflate stream in a gzip file.
+/// @param data The start of the file.
+/// @param len The length of the data.
+/// @return The length of the gzip header, or 0 if the header isn't valid.
+size_t FirmwareUpdater::skipGzipHeader(const uint8_t* data, size_t len)
+{
+    // Fixed header: ID1, ID2, method, flags, mtime, extra flags, OS
+    if (len < 10 || data[2] != 8)
+    {
+        return 0;
+    }
+    uint8_t flags = data[3];
+    size_t offset = 10;
+    // Optional extra field
+    if (flags & 0x04)
+    {
+        if (offset + 2 > len)
+        {
+            return 0;
+        }
+        offset += 2 + (data[offset] | (data[offset + 1] << 8));
+    }
+    // Optional zero terminated file name and comment
+    for (uint8_t field = 0x08; field <= 0x10; field <<= 1)
+    {
+        if (flags & field)
+        {
+            while (offset < len && data[offset] != 0)
+            {
+                offset++;
+            }
+            offset++;
+        }
+    }
+    // Optional header CRC
+    if (flags & 0x02)
+    {
+        offset += 2;
+    }
+    return offset < len ? offset : 0;
+}
+
+/// @brief Wraps the writer task for static access.
+/// @param arg The FirmwareUpdater object.
+void FirmwareUpdater::WriterTaskWrapper(void* arg)
+{
+    static_cast<FirmwareUpdater*>(arg)->WriterTask();
+}
+
+/// @brief Writes and hashes full buffers until told to finish or abort the update.
+void FirmwareUpdater::WriterTask()
+{
+    Block block;
+    while (true)
+    {
+        if (xQueueReceive(fullBlocks, &block, ResumeInterval / portTICK_PERIOD_MS) != pdTRUE)
+        {
+            // A pause can begin just after the last buffer was freed
+            resume();
+            continue;
+        }
+        if (block.index == FinishUpdate)
+        {
+            finish();
+            break;
+        }
+        if (block.index == AbortUpdate)
+        {
+            discard();
+            break;
+        }
+        uint8_t* data = buffers[block.index];
+        size_t length = block.length;
+        if (Stats.received == 0 && length >= 2 && data[0] == 0x1f && data[1] == 0x8b)
+        {
+            // Gzip image, the header must fit in the first sector
+            size_t header = skipGzipHeader(data, length);
+            inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+            window = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+            if (header == 0 || inflator == NULL || window == NULL)
+            {
+                Logger::error("Can't decompress update");
+                failed = true;
+            }
+            else
+            {
+                tinfl_init(inflator);
+                windowOffset = 0;
+                Stats.compressed = true;
+                data += header;
+                length -= header;
+            }
+        }
+        Stats.received += block.length;
+        if (!failed)
+        {
+            failed = Stats.compressed ? !inflate(data, length) : !store(data, length);
+        }
+        xQueueSend(freeBlocks, &block.index, 0);
+        resume();
+    }
+    vTaskDelete(NULL);
+}
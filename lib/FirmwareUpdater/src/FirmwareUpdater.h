@@ -0,0 +1,150 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <Update.h>
+#include <mbedtls/sha256.h>
+#include <esp32/rom/miniz.h>
+#include <Logger.h>
+
+/// @brief Writes a firmware image to flash in whole sectors from its own task, verifying its SHA-256 before committing.
+/// Gzip compressed images are decompressed as they are written. The network side never waits on flash, the client is paused instead.
+class FirmwareUpdater
+{
+    public:
+        /// @brief Results of the last update.
+        struct Statistics
+        {
+            /// @brief Bytes written to flash.
+            size_t bytes;
+            /// @brief Bytes received over the network.
+            size_t received;
+            /// @brief True if the image was gzip compressed.
+            bool compressed;
+            /// @brief Time from the first to the last byte, in milliseconds.
+            uint32_t duration;
+            /// @brief Average throughput in bytes per second.
+            uint32_t throughput;
+            /// @brief SHA-256 of the image written to flash as a hex string.
+            char hash[65];
+            /// @brief True if the image was checked against an expected hash.
+            bool verified;
+            /// @brief True if the image was committed.
+            bool success;
+        };
+
+        /// @brief Results of the last update.
+        Statistics Stats = { 0, 0, false, 0, 0, "", false, false };
+
+        FirmwareUpdater();
+        bool begin(const String& expectedHash, const void* requester, AsyncClient* client);
+        bool write(const void* requester, const uint8_t* data, size_t len);
+        bool end(const void* requester);
+        void abort(const void* requester);
+        bool startedBy(const void* requester);
+        bool inProgress();
+        bool hasError();
+        String getStatistics();
+        static void WriterTaskWrapper(void* arg);
+
+    private:
+        /// @brief Size of a flash sector, each buffer is written in one call.
+        static const size_t SectorSize = 4096;
+
+        /// @brief Number of sector buffers.
+        static const int BufferCount = 5;
+
+        /// @brief The client is paused when less buffer space than this is left, more than the TCP window the client can still send.
+        static const size_t ReserveSpace = 2 * SectorSize;
+
+        /// @brief How often the writer checks if a paused client can resume while it has nothing to write, in milliseconds.
+        static const int ResumeInterval = 10;
+
+        /// @brief Block indices telling the writer task to stop.
+        enum WriterCommands { AbortUpdate = -1, FinishUpdate = -2 };
+
+        /// @brief A buffer handed to the writer task.
+        struct Block
+        {
+            /// @brief Index of the buffer, or a command to stop the writer.
+            int index;
+            /// @brief Number of bytes used in the buffer.
+            size_t length;
+        };
+
+        /// @brief Sector buffers, filled by the network while others are written.
+        uint8_t* buffers[BufferCount] = { NULL, NULL, NULL, NULL, NULL };
+
+        /// @brief Index of the buffer being filled, -1 if none has been taken yet.
+        int active = -1;
+
+        /// @brief Number of bytes in the buffer being filled.
+        size_t fill = 0;
+
+        /// @brief Buffers waiting to be written, with room for every buffer and a stop command.
+        QueueHandle_t fullBlocks;
+
+        /// @brief Buffers free to be filled.
+        QueueHandle_t freeBlocks;
+
+        /// @brief The connection the image is received on, acknowledged by the writer task while it's paused.
+        AsyncClient* client = NULL;
+
+        /// @brief Guards client, held by the writer only while it acknowledges data.
+        SemaphoreHandle_t clientLock;
+
+        /// @brief True while received data is left unacknowledged so the client stops sending.
+        volatile bool paused = false;
+
+        /// @brief True once the writer has been told to finish or abort the update.
+        bool stopping = false;
+
+        /// @brief Inflater state for compressed images, NULL for uncompressed images.
+        tinfl_decompressor* inflator = NULL;
+
+        /// @brief Sliding window of decompressed output, as required by the inflater.
+        uint8_t* window = NULL;
+
+        /// @brief Position of the next output byte in the window.
+        size_t windowOffset = 0;
+
+        /// @brief True once the end of the compressed stream has been reached.
+        bool inflated = false;
+
+        /// @brief Hash of the image written so far.
+        mbedtls_sha256_context sha;
+
+        /// @brief The hash the image must match, if any.
+        uint8_t expected[32];
+
+        /// @brief True if an expected hash was given.
+        bool checkHash = false;
+
+        /// @brief True while an update is in progress.
+        bool running = false;
+
+        /// @brief The request that started the current or last update, only it can write to or end the update.
+        const void* owner = NULL;
+
+        /// @brief Set when writing fails.
+        volatile bool failed = false;
+
+        /// @brief Time the update started.
+        uint32_t startTime = 0;
+
+        void queueActive();
+        void stopWriter(int command);
+        void resume();
+        void finish();
+        void discard();
+        void release();
+        bool store(uint8_t* data, size_t len);
+        bool inflate(const uint8_t* data, size_t len);
+        size_t skipGzipHeader(const uint8_t* data, size_t len);
+        void WriterTask();
+};
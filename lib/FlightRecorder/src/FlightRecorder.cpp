@@ -0,0 +1,75 @@
+#include "FlightRecorder.h"
+
+/// @brief Tags the following samples with a new command. Call only from the command processor task.
+/// @param commandType The type of the command.
+/// @param command The command.
+void FlightRecorder::beginCommand(int commandType, int command)
+{
+    commandId++;
+    this->commandType = commandType;
+    this->command = command;
+    commandStarts[commandId % MaxCommands] = count.load(std::memory_order_relaxed);
+}
+
+/// @brief Records a control loop sample, overwriting the oldest. Call only from the command processor task.
+/// @param gyroRate The gyro rate in degrees per second.
+/// @param angle The integrated angle in degrees.
+/// @param leftServo The left servo command.
+/// @param rightServo The right servo command.
+void FlightRecorder::record(float gyroRate, float angle, int leftServo, int rightServo)
+{
+    uint32_t index = count.load(std::memory_order_relaxed);
+    records[index % Capacity] = Record { (uint32_t)millis(), commandId, commandType, command, (int16_t)leftServo, (int16_t)rightServo, gyroRate, angle };
+    count.store(index + 1, std::memory_order_release);
+}
+
+/// @brief Finds the oldest sample still held from a number of recent commands.
+/// @param commands The number of commands, including the current one.
+/// @return The sample number.
+uint32_t FlightRecorder::firstRecord(int commands)
+{
+    uint32_t end = count.load(std::memory_order_acquire);
+    uint32_t oldest = end > Capacity ? end - Capacity : 0;
+    uint16_t id = commandId;
+    commands = constrain(commands, 1, min((int)MaxCommands, (int)id));
+    if (id == 0)
+    {
+        return oldest;
+    }
+    uint32_t start = commandStarts[(uint16_t)(id - commands + 1) % MaxCommands];
+    return max(start, oldest);
+}
+
+/// @brief Gets the number of the next sample to be recorded.
+/// @return The sample number.
+uint32_t FlightRecorder::endRecord()
+{
+    return count.load(std::memory_order_acquire);
+}
+
+/// @brief Copies a sample. Safe to call from any task.
+/// @param index The sample number.
+/// @param record Receives the sample.
+/// @return True if the sample was available and wasn't overwritten while being copied.
+bool FlightRecorder::read(uint32_t index, Record& record)
+{
+    if (index >= count.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    record = records[index % Capacity];
+    // The copy is only valid if the slot wasn't reused during it
+    return count.load(std::memory_order_acquire) - index <= Capacity - 1;
+}
+
+/// @brief Formats a sample as a line of CSV.
+/// @param record The sample.
+/// @param buffer Receives the line.
+/// @param length The size of the buffer.
+/// @return The length of the line, or 0 if it didn't fit.
+size_t FlightRecorder::formatCSV(const Record& record, char* buffer, size_t length)
+{
+    int written = snprintf(buffer, length, "%u,%u,%u,%u,%d,%d,%.2f,%.2f\n", record.timestamp, record.commandId, record.commandType,
+        record.command, record.leftServo, record.rightServo, record.gyroRate, record.angle);
+    return written > 0 && written < (int)length ? written : 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Keeps the most recent control loop samples in RAM so a bad move can be examined afterwards.
+ * Binary downloads are a sequence of 20-byte records, all fields little-endian:
+ * uint32 timestamp (ms), uint16 command ID, uint8 command type, uint8 command,
+ * int16 left servo command, int16 right servo command, float gyro rate (degrees/s),
+ * float integrated angle (degrees).
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+/// @brief Fixed-size RAM ring of control loop samples, overwriting the oldest.
+class FlightRecorder
+{
+    public:
+        /// @brief A single control loop sample.
+        struct __attribute__((packed)) Record
+        {
+            uint32_t timestamp;
+            /// @brief Incremented for each command, so samples can be grouped by move
+            uint16_t commandId;
+            uint8_t commandType;
+            uint8_t command;
+            int16_t leftServo;
+            int16_t rightServo;
+            float gyroRate;
+            float angle;
+        };
+
+        /// @brief Number of samples kept.
+        static const uint32_t Capacity = 1024;
+
+        /// @brief Number of commands whose starting samples are remembered.
+        static const uint32_t MaxCommands = 32;
+
+        void beginCommand(int commandType, int command);
+        void record(float gyroRate, float angle, int leftServo, int rightServo);
+        uint32_t firstRecord(int commands);
+        uint32_t endRecord();
+        bool read(uint32_t index, Record& record);
+        static size_t formatCSV(const Record& record, char* buffer, size_t length);
+
+    private:
+        /// @brief Sample storage, indexed by the sample number modulo Capacity.
+        Record records[Capacity];
+
+        /// @brief Number of samples ever recorded.
+        std::atomic<uint32_t> count { 0 };
+
+        /// @brief The sample number each recent command started at, indexed by command ID modulo MaxCommands.
+        uint32_t commandStarts[MaxCommands] = { 0 };
+
+        /// @brief ID of the current command, 0 before the first.
+        uint16_t commandId = 0;
+
+        /// @brief Type of the current command.
+        uint8_t commandType = 0;
+
+        /// @brief The current command.
+        uint8_t command = 0;
+};
@@ -10,20 +10,38 @@ HTTPCommunication::HTTPCommunication(Configuration* Config)
 /// @brief Sends bot info to the server.
 /// @param name The name of the robot.
 /// @param lateralMovement If the robot supports lateral movement
+/// @param voltage The battery voltage, 0 if not measured.
+/// @param player The player the robot was assigned before restarting, 0 if none.
+/// @param robotNumber The robot number it was assigned before restarting.
 /// @return True on success.
-bool HTTPCommunication::JoinGame(String name)
+bool HTTPCommunication::JoinGame(String name, float voltage, int player, int robotNumber)
 {
     Serial.println("Sending bot info");
     JsonDocument botInfo;
     botInfo["name"] = name;
     botInfo["ip"] = getLocalAddress().toString();
+    botInfo["profile"] = config->getActiveProfile();
+    if (voltage > 0)
+    {
+        botInfo["voltage"] = voltage;
+    }
+    // Ask to keep the same assignment, the server can still assign the robot again
+    if (player > 0)
+    {
+        botInfo["player"] = player;
+        botInfo["botNumber"] = robotNumber;
+    }
     String info;
     serializeJson(botInfo, info);
     Serial.println(info);
     HTTPClient client;
     client.begin("http://" + config->ServerConfig.ServerIP + ":" + config->ServerConfig.ServerPort + "/bot");
     client.addHeader("Content-Type", "application/json");
-    int resultCode = client.PUT(info);
+    int resultCode;
+    {
+        PROFILE_SCOPE("Join game request");
+        resultCode = client.PUT(info);
+    }
     Serial.println("Result code: " + String(resultCode));
     bool success = false;
     if (resultCode == HTTP_CODE_ACCEPTED)
@@ -47,19 +65,23 @@ bool HTTPCommunication::SignalDone(int id)
     bool success = false;
     int retry_count = 0;
     while (millis() < timeout) {
-        Serial.println("Sending done moving");
+        Logger::debug("Sending done moving");
         HTTPClient client;
         client.begin("http://" + config->ServerConfig.ServerIP + ":" + config->ServerConfig.ServerPort + "/bot/Done/");
         client.addHeader("Content-Type", "application/json");
-        int resultCode = client.POST("{\"bot\": " + String(id) + "}");
-        Serial.println("Result code: " + String(resultCode));
+        int resultCode;
+        {
+            PROFILE_SCOPE("Signal done request");
+            resultCode = client.POST("{\"bot\": " + String(id) + "}");
+        }
+        Logger::debug("Result code: %d", resultCode);
         if (resultCode == HTTP_CODE_ACCEPTED)
         {
             success = true;
         }
         else
         {
-            Serial.println("FAIL: " + client.errorToString(resultCode) + " " + client.getString());
+            Logger::warning("FAIL: %s %s", client.errorToString(resultCode).c_str(), client.getString().c_str());
         }
         client.end();
         if (success || retry_count >= 3) 
@@ -71,6 +93,180 @@ bool HTTPCommunication::SignalDone(int id)
     return success;
 }
 
+/// @brief Measures the offset between the game server clock and the local clock.
+/// Makes several round trips to the server's /bot/Time/ endpoint, which replies with
+/// {"receive": time the request arrived, "transmit": time the reply was sent} in milliseconds,
+/// and keeps the one with the shortest round trip.
+/// @return True on success.
+bool HTTPCommunication::SyncClock()
+{
+    HTTPClient client;
+    client.setReuse(true);
+    client.begin("http://" + config->ServerConfig.ServerIP + ":" + config->ServerConfig.ServerPort + "/bot/Time/");
+    ClockSample best;
+    double bestRoundTrip = -1;
+    for (int i = 0; i < 5; i++)
+    {
+        int64_t sent = esp_timer_get_time();
+        int resultCode;
+        {
+            PROFILE_SCOPE("Clock sync request");
+            resultCode = client.GET();
+        }
+        int64_t received = esp_timer_get_time();
+        syncResult = resultCode;
+        if (resultCode != HTTP_CODE_OK)
+        {
+            Logger::warning("Clock sync FAIL: %s", client.errorToString(resultCode).c_str());
+            break;
+        }
+        JsonDocument reply;
+        if (deserializeJson(reply, client.getString()))
+        {
+            Logger::warning("Bad clock sync reply");
+            break;
+        }
+        double serverReceive = reply["receive"].as<double>();
+        double serverTransmit = reply["transmit"].as<double>();
+        // Standard NTP offset and delay, in milliseconds
+        double offset = ((serverReceive - sent / 1000.0) + (serverTransmit - received / 1000.0)) / 2;
+        double trip = (received - sent) / 1000.0 - (serverTransmit - serverReceive);
+        if (bestRoundTrip < 0 || trip < bestRoundTrip)
+        {
+            best = ClockSample { (sent + received) / 2, offset };
+            bestRoundTrip = trip;
+        }
+    }
+    client.end();
+    if (bestRoundTrip < 0)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&clockLock);
+    samples[nextSample] = best;
+    nextSample = (nextSample + 1) % ClockSamples;
+    sampleCount = min(sampleCount + 1, ClockSamples);
+    roundTrip = bestRoundTrip;
+    fitClock();
+    portEXIT_CRITICAL(&clockLock);
+    Logger::info("Clock offset %.3fms, drift %.1fppm, residual %.3fms, round trip %.3fms", fitOffset, drift * 1e6, residual, roundTrip);
+    return true;
+}
+
+/// @brief Starts synchronizing the clock with the game server in the background.
+void HTTPCommunication::beginClockSync()
+{
+    xTaskCreate(HTTPCommunication::ClockSyncTaskWrapper, "Clock Sync", 4096, this, 1, NULL);
+}
+
+/// @brief Converts a game server time to local time.
+/// @param serverTime The server time in milliseconds.
+/// @param localTime Receives the local time in microseconds, comparable to esp_timer_get_time().
+/// @return True on success, false if the clock hasn't been synchronized.
+bool HTTPCommunication::serverToLocal(double serverTime, int64_t &localTime)
+{
+    portENTER_CRITICAL(&clockLock);
+    bool synchronized = sampleCount > 0;
+    // Solve serverTime = local + fitOffset + drift * (local - fitTime) for local
+    double local = (serverTime - fitOffset + drift * fitTime) / (1 + drift);
+    portEXIT_CRITICAL(&clockLock);
+    localTime = (int64_t)(local * 1000);
+    return synchronized;
+}
+
+/// @brief Records how accurately a scheduled move started.
+/// @param error Actual minus scheduled start time in microseconds.
+void HTTPCommunication::recordScheduledStart(int64_t error)
+{
+    // A 64-bit write isn't atomic on the ESP32
+    portENTER_CRITICAL(&clockLock);
+    lastStartError = error;
+    portEXIT_CRITICAL(&clockLock);
+}
+
+/// @brief Retrieves the state of the clock synchronization.
+/// @return A JSON string of the offset, drift and residual error.
+String HTTPCommunication::getClockStatus()
+{
+    // Copy the estimate first, the document allocates memory which can't be done holding the lock
+    portENTER_CRITICAL(&clockLock);
+    int count = sampleCount;
+    double offset = fitOffset + drift * (esp_timer_get_time() / 1000.0 - fitTime);
+    double currentDrift = drift;
+    double currentResidual = residual;
+    double trip = roundTrip;
+    int64_t startError = lastStartError;
+    portEXIT_CRITICAL(&clockLock);
+    JsonDocument status;
+    status["synchronized"] = count > 0;
+    status["samples"] = count;
+    status["offset"] = offset;
+    status["drift"] = currentDrift * 1e6;
+    status["residual"] = currentResidual;
+    status["roundTrip"] = trip;
+    status["lastStartError"] = startError / 1000.0;
+    String result;
+    serializeJson(status, result);
+    return result;
+}
+
+/// @brief Wraps the clock sync task for static access.
+/// @param arg The HTTPCommunication object.
+void HTTPCommunication::ClockSyncTaskWrapper(void* arg)
+{
+    static_cast<HTTPCommunication*>(arg)->ClockSyncTask();
+}
+
+/// @brief Fits the offset and drift to the stored samples by least squares. Call with clockLock held.
+void HTTPCommunication::fitClock()
+{
+    double meanTime = 0, meanOffset = 0;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        meanTime += samples[i].local / 1000.0;
+        meanOffset += samples[i].offset;
+    }
+    meanTime /= sampleCount;
+    meanOffset /= sampleCount;
+    double covariance = 0, variance = 0;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        double time = samples[i].local / 1000.0 - meanTime;
+        covariance += time * (samples[i].offset - meanOffset);
+        variance += time * time;
+    }
+    drift = variance > 0 ? covariance / variance : 0;
+    fitTime = meanTime;
+    fitOffset = meanOffset;
+    double squares = 0;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        double error = samples[i].offset - (fitOffset + drift * (samples[i].local / 1000.0 - fitTime));
+        squares += error * error;
+    }
+    residual = sqrt(squares / sampleCount);
+}
+
+/// @brief Runs in an infinite loop periodically synchronizing the clock.
+void HTTPCommunication::ClockSyncTask()
+{
+    uint32_t retry = ClockSyncRetry;
+    while (true)
+    {
+        if (SyncClock())
+        {
+            retry = ClockSyncRetry;
+        }
+        else if (syncResult == HTTP_CODE_NOT_FOUND)
+        {
+            // The game server doesn't support clock sync, only check back occasionally in case it's updated
+            retry = min(retry * 2, ClockSyncMaxRetry);
+        }
+        // Sync quickly until the drift can be estimated, then settle down
+        vTaskDelay((sampleCount < 3 ? retry : 30000) / portTICK_PERIOD_MS);
+    }
+}
+
 /// @brief Retrieves the current IP of the sensor hub
 /// @return The IP address.
 IPAddress HTTPCommunication::getLocalAddress()
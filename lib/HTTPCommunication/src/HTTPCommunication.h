@@ -10,8 +10,11 @@
 #pragma once
 #include <Arduino.h>
 #include <HTTPClient.h>
+#include <esp_timer.h>
 #include <ArduinoJson.h>
 #include <Configuration.h>
+#include <Profiler.h>
+#include <Logger.h>
 
 class HTTPCommunication 
 {
@@ -19,10 +22,70 @@ class HTTPCommunication
         // Public methods
         IPAddress getLocalAddress();
         HTTPCommunication(Configuration* Config);
-        bool JoinGame(String name);
+        bool JoinGame(String name, float voltage = 0, int player = 0, int robotNumber = 0);
         bool SignalDone(int id);
+        bool SyncClock();
+        void beginClockSync();
+        bool serverToLocal(double serverTime, int64_t &localTime);
+        void recordScheduledStart(int64_t error);
+        String getClockStatus();
+        static void ClockSyncTaskWrapper(void* arg);
 
     private:
+        /// @brief A measured offset between the game server clock and the local clock
+        struct ClockSample
+        {
+            /// @brief Local time of the measurement in microseconds
+            int64_t local;
+            /// @brief Server time minus local time in milliseconds
+            double offset;
+        };
+
+        /// @brief Number of samples the drift estimate is fitted to
+        static constexpr int ClockSamples = 8;
+
+        /// @brief Time between clock syncs until the drift can be estimated, in milliseconds
+        static const uint32_t ClockSyncRetry = 2000;
+
+        /// @brief Longest time between clock syncs when the server doesn't support them, in milliseconds
+        static constexpr uint32_t ClockSyncMaxRetry = 300000;
+
         /// @brief A reference to a confiuration object
         Configuration* config;
+
+        /// @brief Recent clock measurements, oldest overwritten first
+        ClockSample samples[ClockSamples];
+
+        /// @brief Number of valid samples
+        int sampleCount = 0;
+
+        /// @brief Index the next sample is stored at
+        int nextSample = 0;
+
+        /// @brief Mean local time of the samples in milliseconds, the fit is centred here
+        double fitTime = 0;
+
+        /// @brief Fitted offset at fitTime in milliseconds
+        double fitOffset = 0;
+
+        /// @brief Fitted drift of the server clock relative to the local clock, in ms per ms
+        double drift = 0;
+
+        /// @brief RMS difference between the samples and the fit in milliseconds
+        double residual = 0;
+
+        /// @brief Round trip time of the last accepted sample in milliseconds
+        double roundTrip = 0;
+
+        /// @brief Difference between the scheduled and actual start of the last scheduled move in microseconds, guarded by clockLock
+        int64_t lastStartError = 0;
+
+        /// @brief HTTP result code of the last clock sync request
+        int syncResult = 0;
+
+        /// @brief Guards the clock estimate, which is read and written from different tasks
+        portMUX_TYPE clockLock = portMUX_INITIALIZER_UNLOCKED;
+
+        void fitClock();
+        void ClockSyncTask();
 };
\ No newline at end of file
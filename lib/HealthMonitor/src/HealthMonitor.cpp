@@ -0,0 +1,124 @@
+#include "HealthMonitor.h"
+
+volatile int64_t HealthMonitor::idleTime[2] = { 0, 0 };
+volatile int64_t HealthMonitor::lastIdle[2] = { 0, 0 };
+
+/// @brief Starts measuring idle time and sampling the robot's resources.
+void HealthMonitor::begin()
+{
+    esp_register_freertos_idle_hook_for_cpu(HealthMonitor::idleHookCore0, 0);
+    esp_register_freertos_idle_hook_for_cpu(HealthMonitor::idleHookCore1, 1);
+    xTaskCreate(HealthMonitor::HealthTaskWrapper, "Health Monitor", 3072, this, 1, NULL);
+}
+
+/// @brief Gets the latest sample, recent trends and the stack usage of every task.
+/// @return A JSON string of the robot's health.
+String HealthMonitor::getHealth()
+{
+    JsonDocument health;
+    portENTER_CRITICAL(&historyLock);
+    uint32_t count = sampleCount;
+    Sample samples[HistoryLength];
+    memcpy(samples, history, sizeof(samples));
+    portEXIT_CRITICAL(&historyLock);
+    if (count > 0)
+    {
+        const Sample& latest = samples[(count - 1) % HistoryLength];
+        health["uptime"] = latest.uptime;
+        health["freeHeap"] = latest.freeHeap;
+        health["largestBlock"] = latest.largestBlock;
+        health["minimumHeap"] = latest.minimumHeap;
+        health["idle"][0] = latest.idle[0];
+        health["idle"][1] = latest.idle[1];
+    }
+    // Oldest first
+    JsonArray trend = health["history"].to<JsonArray>();
+    for (uint32_t i = count > HistoryLength ? count - HistoryLength : 0; i < count; i++)
+    {
+        const Sample& sample = samples[i % HistoryLength];
+        JsonObject point = trend.add<JsonObject>();
+        point["uptime"] = sample.uptime;
+        point["freeHeap"] = sample.freeHeap;
+        point["largestBlock"] = sample.largestBlock;
+    }
+    // Stack high water marks are the least free stack each task has ever had, in bytes
+    TaskStatus_t tasks[MaxTasks];
+    UBaseType_t taskCount = uxTaskGetSystemState(tasks, MaxTasks, NULL);
+    JsonObject stacks = health["stackFree"].to<JsonObject>();
+    for (UBaseType_t i = 0; i < taskCount; i++)
+    {
+        stacks[tasks[i].pcTaskName] = tasks[i].usStackHighWaterMark;
+    }
+    String health_string;
+    serializeJson(health, health_string);
+    return health_string;
+}
+
+/// @brief Accumulates idle time, called repeatedly by each core's idle task.
+/// @param core The core the idle task is running on.
+/// @return True to let the idle task sleep until the next interrupt.
+bool HealthMonitor::idleHook(int core)
+{
+    int64_t now = esp_timer_get_time();
+    // Consecutive calls are at most a tick apart while idle, longer gaps mean another task ran
+    if (now - lastIdle[core] < IdleGap)
+    {
+        idleTime[core] += now - lastIdle[core];
+    }
+    lastIdle[core] = now;
+    return true;
+}
+
+/// @brief Idle hook for core 0.
+/// @return True to let the idle task sleep.
+bool HealthMonitor::idleHookCore0()
+{
+    return idleHook(0);
+}
+
+/// @brief Idle hook for core 1.
+/// @return True to let the idle task sleep.
+bool HealthMonitor::idleHookCore1()
+{
+    return idleHook(1);
+}
+
+/// @brief Wraps the health monitor task for static access.
+/// @param arg The HealthMonitor object.
+void HealthMonitor::HealthTaskWrapper(void* arg)
+{
+    static_cast<HealthMonitor*>(arg)->HealthTask();
+}
+
+/// @brief Runs in an infinite loop sampling the robot's resources.
+void HealthMonitor::HealthTask()
+{
+    int64_t lastTime = esp_timer_get_time();
+    int64_t lastIdleTime[2] = { idleTime[0], idleTime[1] };
+    while (true)
+    {
+        vTaskDelay(SamplePeriod / portTICK_PERIOD_MS);
+        int64_t now = esp_timer_get_time();
+        Sample sample;
+        sample.uptime = now / 1000000;
+        sample.freeHeap = ESP.getFreeHeap();
+        sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        sample.minimumHeap = ESP.getMinFreeHeap();
+        for (int core = 0; core < 2; core++)
+        {
+            int64_t idle = idleTime[core];
+            sample.idle[core] = constrain(100.0f * (idle - lastIdleTime[core]) / (now - lastTime), 0.0f, 100.0f);
+            lastIdleTime[core] = idle;
+        }
+        lastTime = now;
+        portENTER_CRITICAL(&historyLock);
+        history[sampleCount % HistoryLength] = sample;
+        sampleCount++;
+        portEXIT_CRITICAL(&historyLock);
+        if (sampleCount % LogInterval == 0)
+        {
+            Logger::info("Health: heap %u free, %u largest, %u minimum, idle %.0f%%/%.0f%%", sample.freeHeap, sample.largestBlock,
+                sample.minimumHeap, sample.idle[0], sample.idle[1]);
+        }
+    }
+}
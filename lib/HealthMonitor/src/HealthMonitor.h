@@ -0,0 +1,78 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Periodically samples heap usage and fragmentation, task stack usage and CPU load,
+ * so stacks can be sized from measurements and memory problems caught before they crash the robot.
+ *
+ * External libraries needed:
+ * ArduinoJson: https://github.com/bblanchon/ArduinoJson
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <esp_freertos_hooks.h>
+#include <esp_timer.h>
+#include <Logger.h>
+
+class HealthMonitor
+{
+    public:
+        /// @brief A snapshot of the robot's resources.
+        struct Sample
+        {
+            /// @brief Seconds since boot.
+            uint32_t uptime;
+            /// @brief Free heap in bytes.
+            uint32_t freeHeap;
+            /// @brief Largest allocatable block in bytes, much smaller than the free heap when it's fragmented.
+            uint32_t largestBlock;
+            /// @brief Lowest free heap since boot in bytes.
+            uint32_t minimumHeap;
+            /// @brief Percentage of time each core was idle over the last period.
+            float idle[2];
+        };
+
+        void begin();
+        String getHealth();
+        static void HealthTaskWrapper(void* arg);
+
+    private:
+        /// @brief Time between samples in milliseconds.
+        static const int SamplePeriod = 10000;
+
+        /// @brief Number of samples kept for trends.
+        static const int HistoryLength = 30;
+
+        /// @brief Number of samples between log messages.
+        static const int LogInterval = 6;
+
+        /// @brief Maximum number of tasks reported.
+        static const int MaxTasks = 24;
+
+        /// @brief Gaps between idle hook calls longer than this, in microseconds, are assumed to be other tasks running.
+        static const int64_t IdleGap = 1500;
+
+        /// @brief Recent samples, the oldest overwritten first.
+        Sample history[HistoryLength];
+
+        /// @brief Number of samples ever taken.
+        uint32_t sampleCount = 0;
+
+        /// @brief Guards the history.
+        portMUX_TYPE historyLock = portMUX_INITIALIZER_UNLOCKED;
+
+        /// @brief Microseconds each core has spent idle since boot.
+        static volatile int64_t idleTime[2];
+
+        /// @brief Time of the last idle hook call on each core.
+        static volatile int64_t lastIdle[2];
+
+        static bool idleHook(int core);
+        static bool idleHookCore0();
+        static bool idleHookCore1();
+        void HealthTask();
+};
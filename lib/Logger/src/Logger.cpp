@@ -0,0 +1,194 @@
+#include "Logger.h"
+
+Logger::Slot Logger::slots[Logger::Capacity];
+std::atomic<uint32_t> Logger::enqueuePosition { 0 };
+uint32_t Logger::dequeuePosition = 0;
+std::atomic<uint32_t> Logger::dropped { 0 };
+volatile Logger::Levels Logger::minimumLevel = Logger::Info;
+AsyncWebSocket Logger::socket("/log");
+
+/// @brief Starts the task writing out queued messages. Messages logged before this are kept until it starts.
+void Logger::begin()
+{
+    xTaskCreate(Logger::LoggerTaskWrapper, "Logger", 3072, NULL, 1, NULL);
+}
+
+/// @brief Gets the WebSocket handler to register with the web server.
+/// @return The WebSocket handler.
+AsyncWebSocket* Logger::getSocket()
+{
+    return &socket;
+}
+
+/// @brief Sets the least severe level of message logged.
+/// @param level The level.
+void Logger::setLevel(Levels level)
+{
+    minimumLevel = level;
+}
+
+/// @brief Logs a message. Never blocks.
+/// @param level The message severity.
+/// @param format A printf style format string.
+void Logger::log(Levels level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(level, format, args);
+    va_end(args);
+}
+
+/// @brief Logs a debug message. Never blocks.
+/// @param format A printf style format string.
+void Logger::debug(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(Debug, format, args);
+    va_end(args);
+}
+
+/// @brief Logs an informational message. Never blocks.
+/// @param format A printf style format string.
+void Logger::info(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(Info, format, args);
+    va_end(args);
+}
+
+/// @brief Logs a warning. Never blocks.
+/// @param format A printf style format string.
+void Logger::warning(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(Warning, format, args);
+    va_end(args);
+}
+
+/// @brief Logs an error. Never blocks.
+/// @param format A printf style format string.
+void Logger::error(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(Error, format, args);
+    va_end(args);
+}
+
+/// @brief Gets the number of messages dropped because the queue was full.
+/// @return The number of messages.
+uint32_t Logger::getDropped()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+/// @brief Formats and queues a message.
+/// @param level The message severity.
+/// @param format A printf style format string.
+/// @param args The format arguments.
+void Logger::vlog(Levels level, const char* format, va_list args)
+{
+    if (level < minimumLevel)
+    {
+        return;
+    }
+    Entry entry;
+    entry.timestamp = millis();
+    entry.level = level;
+    vsnprintf(entry.message, sizeof(entry.message), format, args);
+    if (!push(entry))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// @brief Adds a message to the queue. Safe to call from any number of tasks at once.
+/// @param entry The message.
+/// @return True on success, false if the queue is full.
+bool Logger::push(const Entry& entry)
+{
+    uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[position % Capacity];
+        // A slot is free to write when its sequence matches the position
+        int32_t difference = (int32_t)(slot->sequence.load(std::memory_order_acquire) + position % Capacity - position);
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->entry = entry;
+    slot->sequence.store(position + 1 - position % Capacity, std::memory_order_release);
+    return true;
+}
+
+/// @brief Removes the oldest message from the queue. Only call from the logger task.
+/// @param entry Receives the message.
+/// @return True on success, false if the queue is empty.
+bool Logger::pop(Entry& entry)
+{
+    uint32_t index = dequeuePosition % Capacity;
+    Slot* slot = &slots[index];
+    if ((int32_t)(slot->sequence.load(std::memory_order_acquire) + index - (dequeuePosition + 1)) < 0)
+    {
+        return false;
+    }
+    entry = slot->entry;
+    // Free the slot for the writer one lap later
+    slot->sequence.store(dequeuePosition + Capacity - index, std::memory_order_release);
+    dequeuePosition++;
+    return true;
+}
+
+/// @brief Wraps the logger task for static access.
+/// @param arg Unused.
+void Logger::LoggerTaskWrapper(void* arg)
+{
+    LoggerTask();
+}
+
+/// @brief Runs in an infinite loop writing queued messages to the serial port and WebSocket subscribers.
+void Logger::LoggerTask()
+{
+    const char* levels[] = { "D", "I", "W", "E" };
+    uint32_t reportedDropped = 0;
+    Entry entry;
+    char line[MessageLength + 32];
+    while (true)
+    {
+        while (pop(entry))
+        {
+            int length = snprintf(line, sizeof(line), "[%lu %s] %s\n", (unsigned long)entry.timestamp, levels[entry.level], entry.message);
+            // Only this task waits on the serial port
+            Serial.write((const uint8_t*)line, length);
+            if (socket.count() > 0 && socket.availableForWriteAll())
+            {
+                socket.textAll(line, length);
+            }
+        }
+        uint32_t droppedNow = getDropped();
+        if (droppedNow != reportedDropped)
+        {
+            Serial.printf("%u log messages dropped\n", droppedNow - reportedDropped);
+            reportedDropped = droppedNow;
+        }
+        socket.cleanupClients();
+        vTaskDelay(20 / portTICK_PERIOD_MS);
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Logs messages without blocking the caller. Messages are formatted into a fixed-size
+ * lock-free queue and written to the serial port and the /log WebSocket by a low-priority task.
+ * If the queue is full the message is dropped and counted instead of waiting.
+ *
+ * External libraries needed:
+ * ESPAsyncWebServer: https://github.com/esphome/ESPAsyncWebServer
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <stdarg.h>
+#include <atomic>
+
+class Logger
+{
+    public:
+        /// @brief Message severity.
+        enum Levels { Debug, Info, Warning, Error };
+
+        static void begin();
+        static AsyncWebSocket* getSocket();
+        static void setLevel(Levels level);
+        static void log(Levels level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+        static void debug(const char* format, ...) __attribute__((format(printf, 1, 2)));
+        static void info(const char* format, ...) __attribute__((format(printf, 1, 2)));
+        static void warning(const char* format, ...) __attribute__((format(printf, 1, 2)));
+        static void error(const char* format, ...) __attribute__((format(printf, 1, 2)));
+        static uint32_t getDropped();
+        static void LoggerTaskWrapper(void* arg);
+
+    private:
+        /// @brief Number of queued messages, must be a power of two.
+        static const uint32_t Capacity = 64;
+
+        /// @brief Maximum length of a message, longer messages are truncated.
+        static const size_t MessageLength = 90;
+
+        /// @brief A formatted message.
+        struct Entry
+        {
+            uint32_t timestamp;
+            uint8_t level;
+            char message[MessageLength + 1];
+        };
+
+        /// @brief A queue slot, its sequence number says whether it's ready to write or to read.
+        /// The sequence is stored relative to the slot's index so the zero-initialized queue is valid before any constructors run.
+        struct Slot
+        {
+            std::atomic<uint32_t> sequence;
+            Entry entry;
+        };
+
+        static Slot slots[Capacity];
+        static std::atomic<uint32_t> enqueuePosition;
+        static uint32_t dequeuePosition;
+        static std::atomic<uint32_t> dropped;
+        static volatile Levels minimumLevel;
+        static AsyncWebSocket socket;
+
+        static void vlog(Levels level, const char* format, va_list args);
+        static bool push(const Entry& entry);
+        static bool pop(Entry& entry);
+        static void LoggerTask();
+};
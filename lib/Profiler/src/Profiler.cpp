@@ -0,0 +1,144 @@
+#include "Profiler.h"
+
+#ifdef RUCKUS_PROFILING
+
+Profiler::Probe Profiler::probes[Profiler::MaxProbes];
+int Profiler::probeCount = 0;
+Profiler::Event Profiler::events[Profiler::TraceEvents];
+uint32_t Profiler::eventCount = 0;
+portMUX_TYPE Profiler::lock = portMUX_INITIALIZER_UNLOCKED;
+
+/// @brief Adds a probe. Called once per probe by PROFILE_SCOPE.
+/// @param name The probe name, must remain valid.
+/// @return The probe index, or -1 if there are too many probes.
+int Profiler::registerProbe(const char* name)
+{
+    portENTER_CRITICAL(&lock);
+    int index = -1;
+    if (probeCount < MaxProbes)
+    {
+        index = probeCount++;
+        probes[index] = Probe { name, 0, 0, UINT32_MAX, 0, { 0 } };
+    }
+    portEXIT_CRITICAL(&lock);
+    return index;
+}
+
+/// @brief Records a completed probe.
+/// @param probe The probe index.
+/// @param startTime The start time in microseconds.
+/// @param cycles The CPU cycles taken.
+void Profiler::record(int probe, int64_t startTime, uint32_t cycles)
+{
+    if (probe < 0)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    Probe& stats = probes[probe];
+    stats.count++;
+    stats.totalCycles += cycles;
+    stats.minCycles = min(stats.minCycles, cycles);
+    stats.maxCycles = max(stats.maxCycles, cycles);
+    stats.histogram[bucket(cycles)]++;
+    events[eventCount++ % TraceEvents] = Event { startTime, cycles, (uint8_t)probe, (uint8_t)xPortGetCoreID() };
+    portEXIT_CRITICAL(&lock);
+}
+
+/// @brief Clears the statistics and trace of all probes.
+void Profiler::reset()
+{
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < probeCount; i++)
+    {
+        probes[i] = Probe { probes[i].name, 0, 0, UINT32_MAX, 0, { 0 } };
+    }
+    eventCount = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+/// @brief Writes the statistics of every probe as JSON, times in microseconds.
+/// @param output Where to write the JSON.
+void Profiler::writeStatistics(Print& output)
+{
+    float cyclesPerMicrosecond = ESP.getCpuFreqMHz();
+    output.print("{");
+    for (int i = 0; i < probeCount; i++)
+    {
+        portENTER_CRITICAL(&lock);
+        Probe stats = probes[i];
+        portEXIT_CRITICAL(&lock);
+        // The 99th percentile is the upper edge of the bucket holding it
+        uint32_t threshold = stats.count - stats.count / 100;
+        uint32_t seen = 0;
+        int percentile = 0;
+        while (percentile < Buckets - 1 && (seen += stats.histogram[percentile]) < threshold)
+        {
+            percentile++;
+        }
+        output.printf("%s\"%s\":{\"count\":%u,\"min\":%.2f,\"avg\":%.2f,\"max\":%.2f,\"p99\":%.2f}", i > 0 ? "," : "", stats.name, stats.count,
+            stats.count > 0 ? stats.minCycles / cyclesPerMicrosecond : 0,
+            stats.count > 0 ? stats.totalCycles / stats.count / cyclesPerMicrosecond : 0,
+            stats.maxCycles / cyclesPerMicrosecond,
+            stats.count > 0 ? min(bucketCycles(percentile + 1), stats.maxCycles) / cyclesPerMicrosecond : 0);
+    }
+    output.print("}");
+}
+
+/// @brief Writes the recent events as Chrome trace event JSON, viewable in chrome://tracing or Perfetto.
+/// @param output Where to write the JSON.
+void Profiler::writeTrace(Print& output)
+{
+    float cyclesPerMicrosecond = ESP.getCpuFreqMHz();
+    int64_t since = esp_timer_get_time() - TraceWindow;
+    portENTER_CRITICAL(&lock);
+    uint32_t end = eventCount;
+    portEXIT_CRITICAL(&lock);
+    uint32_t next = end > TraceEvents ? end - TraceEvents : 0;
+    output.print("{\"traceEvents\":[");
+    bool first = true;
+    for (; next < end; next++)
+    {
+        portENTER_CRITICAL(&lock);
+        // Skip events overwritten while writing the trace
+        bool valid = eventCount - next < TraceEvents;
+        Event event = events[next % TraceEvents];
+        portEXIT_CRITICAL(&lock);
+        if (!valid || event.start < since)
+        {
+            continue;
+        }
+        output.printf("%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%.2f,\"pid\":0,\"tid\":%u}", first ? "" : ",",
+            probes[event.probe].name, event.start, event.cycles / cyclesPerMicrosecond, event.core);
+        first = false;
+    }
+    output.print("],\"displayTimeUnit\":\"ms\"}");
+}
+
+/// @brief Finds the histogram bucket for a duration, two buckets per power of two.
+/// @param cycles The duration in CPU cycles.
+/// @return The bucket index.
+int Profiler::bucket(uint32_t cycles)
+{
+    if (cycles < 2)
+    {
+        return 0;
+    }
+    int octave = 31 - __builtin_clz(cycles);
+    return min(octave * 2 + (int)((cycles >> (octave - 1)) & 1), Buckets - 1);
+}
+
+/// @brief Finds the shortest duration in a histogram bucket.
+/// @param bucket The bucket index.
+/// @return The duration in CPU cycles.
+uint32_t Profiler::bucketCycles(int bucket)
+{
+    if (bucket >= Buckets)
+    {
+        return UINT32_MAX;
+    }
+    int octave = bucket / 2;
+    return (1UL << octave) + (bucket % 2) * (1UL << octave >> 1);
+}
+
+#endif
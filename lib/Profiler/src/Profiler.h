@@ -0,0 +1,100 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Measures how long sections of code take using the CPU cycle counter.
+ * Mark a section with PROFILE_SCOPE("name") at the start of a block; the time until the end of the block is recorded.
+ * Probes only exist when built with -D RUCKUS_PROFILING (see the esp32dev-profiling environment in platformio.ini),
+ * otherwise PROFILE_SCOPE expands to nothing.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+
+#ifdef RUCKUS_PROFILING
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+    static int PROFILE_CONCAT(profileProbe, __LINE__) = Profiler::registerProbe(name); \
+    Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileProbe, __LINE__))
+
+/// @brief Collects timing statistics and a trace of recent events for named probes.
+class Profiler
+{
+    public:
+        /// @brief Times from its creation until it goes out of scope.
+        class Scope
+        {
+            public:
+                /// @brief Starts timing a probe.
+                /// @param Probe The probe index.
+                Scope(int Probe) : probe(Probe), startTime(esp_timer_get_time()), startCycles(ESP.getCycleCount()) {}
+
+                /// @brief Records the time taken.
+                ~Scope() { Profiler::record(probe, startTime, ESP.getCycleCount() - startCycles); }
+
+            private:
+                int probe;
+                int64_t startTime;
+                uint32_t startCycles;
+        };
+
+        static int registerProbe(const char* name);
+        static void record(int probe, int64_t startTime, uint32_t cycles);
+        static void reset();
+        static void writeStatistics(Print& output);
+        static void writeTrace(Print& output);
+
+    private:
+        /// @brief Maximum number of probes.
+        static const int MaxProbes = 24;
+
+        /// @brief Number of histogram buckets, two per power of two cycles.
+        static const int Buckets = 64;
+
+        /// @brief Number of events kept for the trace.
+        static const int TraceEvents = 512;
+
+        /// @brief How far back the trace goes, in microseconds.
+        static const int64_t TraceWindow = 5000000;
+
+        /// @brief Timing statistics of a probe.
+        struct Probe
+        {
+            const char* name;
+            uint32_t count;
+            uint64_t totalCycles;
+            uint32_t minCycles;
+            uint32_t maxCycles;
+            /// @brief Counts of durations, on a logarithmic scale for percentiles
+            uint32_t histogram[Buckets];
+        };
+
+        /// @brief A completed probe for the trace.
+        struct Event
+        {
+            int64_t start;
+            uint32_t cycles;
+            uint8_t probe;
+            uint8_t core;
+        };
+
+        static Probe probes[MaxProbes];
+        static int probeCount;
+        static Event events[TraceEvents];
+        static uint32_t eventCount;
+        static portMUX_TYPE lock;
+
+        static int bucket(uint32_t cycles);
+        static uint32_t bucketCycles(int bucket);
+};
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif
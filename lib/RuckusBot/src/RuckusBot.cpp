@@ -2,10 +2,14 @@
 /// @brief Creates a new robot object.
 /// @param Config A reference to the shared configuration object.
 /// @param communication A reference to the shared HTTPCommunication object.
-RuckusBot::RuckusBot(Configuration *Config, HTTPCommunication *Communication)
+/// @param Telem A reference to the shared Telemetry object.
+/// @param Batt A reference to the shared Battery object.
+RuckusBot::RuckusBot(Configuration *Config, HTTPCommunication *Communication, Telemetry *Telem, Battery *Batt)
 {
     config = Config;
     communication = Communication;
+    telemetry = Telem;
+    battery = Batt;
 }
 
 /// @brief Actually initialize robot with call to begin method
@@ -28,8 +32,6 @@ void RuckusBot::begin()
     // begin() is called a second time to avoid a bug where the gyro counts twice the angle expected
     delay(5);
     mpu6050.begin();
-    // Initial calibration of the gyro
-     calibrateGyro();    
 
     // Start servos
     // Allow allocation of all timers
@@ -130,6 +132,51 @@ void RuckusBot::begin()
         // Save default settings
         config->saveSettings();
     }
+
+    // Add settings introduced since the settings were saved
+    bool added = config->addDefaultSetting("batteryPin", Configuration::BotSetting {
+        displayname : "Battery ADC Pin (0 for none)",
+        min : 0,
+        max : 39,
+        increment : 1,
+        value : 0
+    });
+    added |= config->addDefaultSetting("batteryDivider", Configuration::BotSetting {
+        displayname : "Battery Voltage Divider",
+        min : 1,
+        max : 10,
+        increment : 0.05,
+        value : 2
+    });
+    added |= config->addDefaultSetting("batteryNominal", Configuration::BotSetting {
+        displayname : "Nominal Battery Voltage",
+        min : 3,
+        max : 12,
+        increment : 0.05,
+        value : 4.5
+    });
+    added |= config->addDefaultSetting("batterySpeedGain", Configuration::BotSetting {
+        displayname : "Battery Speed Compensation",
+        min : 0,
+        max : 2,
+        increment : 0.05,
+        value : 0.5
+    });
+    added |= config->addDefaultSetting("batteryTimeGain", Configuration::BotSetting {
+        displayname : "Battery Time Compensation",
+        min : 0,
+        max : 2,
+        increment : 0.05,
+        value : 1
+    });
+    if (added)
+    {
+        config->saveSettings();
+    }
+
+    // Calibrate the gyro in the background while Wi-Fi starts, see waitForGyro()
+    gyroReady = xSemaphoreCreateBinary();
+    xTaskCreate(RuckusBot::GyroTaskWrapper, "Gyro Calibration", 4096, this, 1, NULL);
 }
 
 /// @brief Called when a player is assigned to the robot
@@ -149,6 +196,7 @@ void RuckusBot::showImage(images image, colors color, bool cache)
     if (cache && currentImage != image)
     {
         currentImage = image;
+        WarmRestart::setImage(image);
     }
     FastLED.clear();
     delay(10);
@@ -161,37 +209,58 @@ void RuckusBot::showImage(images image, colors color, bool cache)
 /// @param magnitude How many multiples of 90-degrees to turn.
 void RuckusBot::turn(turnType direction, int magnitude)
 {
-    Serial.println("Turning");
+    Logger::info("Turning");
     // Calculate total turn degrees
-    int target = (config->TunableBotSettings["turnAngle"].value * magnitude) - 10; // The -10 seems to be a hack for the sensor to get accurate turns
+    float target = config->TunableBotSettings["turnAngle"].value * magnitude;
     // Create a smart pointer to a new GyroHelper object. Smart pointer aids in deallocation
-    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050));
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config, simulator));
     // Check direction of turn and activate motors appropriately.
-    if (direction == RuckusBot::turnType::Right)
+    float velocity;
+    if (direction == RuckusBot::turnType::Right && cruiseVelocity(compensated("leftForwardSpeed", "leftZero"), -compensated("rightBackwardSpeed", "rightZero"), velocity))
     {
-        left.write(config->TunableBotSettings["leftForwardSpeed"].value);
-        right.write(config->TunableBotSettings["rightBackwardSpeed"].value);
+        // Equal and opposite wheel velocities from the velocity tables
+        writeServos(config->velocityToPulse(Configuration::LeftWheel, velocity), config->velocityToPulse(Configuration::RightWheel, -velocity));
+    }
+    else if (direction == RuckusBot::turnType::Left && cruiseVelocity(compensated("leftBackwardSpeed", "leftZero"), -compensated("rightForwardSpeed", "rightZero"), velocity))
+    {
+        writeServos(config->velocityToPulse(Configuration::LeftWheel, velocity), config->velocityToPulse(Configuration::RightWheel, -velocity));
+    }
+    else if (direction == RuckusBot::turnType::Right)
+    {
+        writeServos(compensated("leftForwardSpeed", "leftZero"), compensated("rightBackwardSpeed", "rightZero"));
     }
     else if (direction == RuckusBot::turnType::Left)
     {
-        left.write(config->TunableBotSettings["leftBackwardSpeed"].value);
-        right.write(config->TunableBotSettings["rightForwardSpeed"].value);
+        writeServos(compensated("leftBackwardSpeed", "leftZero"), compensated("rightForwardSpeed", "rightZero"));
     }
     else
     {
         // Bad command, exit.
-        Serial.println("Bad turn command");
+        Logger::warning("Bad turn command");
         return;
     }
-    // Keep turning until target angle is met
-    while (abs(helper->getAngle()) < target)
+    long start = millis();
+    float angle;
+    /*
+     * The wheels lose about as much angle spinning up as they coast once stopped, so the turn
+     * should stop when the current rate would have covered the target in the time turned so far.
+     * Wait out the last part of a check interval exactly instead of overshooting by up to 20ms of turning.
+     */
+    while (abs(angle = helper->getAngle()) < target)
     {
-        //Serial.println(abs(helper->getAngle()));
+        telemetry->updateMotion(angle, helper->getRate(), servoCommands[0], servoCommands[1]);
+        float rate = abs(helper->getRate());
+        float remaining = rate > StoppedRate ? target * 1000 / rate - (millis() - start) : 20;
+        if (remaining < 20)
+        {
+            delay(max(remaining, 0.0f));
+            break;
+        }
         delay(20);
     }
     // Stop motors
-    left.write(config->TunableBotSettings["leftZero"].value);
-    right.write(config->TunableBotSettings["rightZero"].value);
+    writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+    telemetry->updateMotion(angle, helper->getRate(), servoCommands[0], servoCommands[1]);
 }
 
 /// @brief Has a bot perform a lateral (slide) motion.
@@ -199,7 +268,7 @@ void RuckusBot::turn(turnType direction, int magnitude)
 /// @param magnitude The number of spaces to slide.
 void RuckusBot::slide(turnType direction, int magnitude)
 {
-    Serial.println("Sliding");
+    Logger::info("Sliding");
     switch (direction)
     {
     case turnType::Left:
@@ -223,94 +292,235 @@ void RuckusBot::slide(turnType direction, int magnitude)
 /// @param magnitude How many spaces to cover
 void RuckusBot::driveForward(int magnitude)
 {
-    Serial.println("Moving forward");
+    Logger::info("Moving forward");
     // Calculate total time needed for the move
-    int total = config->TunableBotSettings["linearTime"].value * magnitude;
-    float gyroX;
+    int total = config->TunableBotSettings["linearTime"].value * magnitude * battery->timeScale();
+    int leftForwardSpeed = compensated("leftForwardSpeed", "leftZero");
+    int rightForwardSpeed = compensated("rightForwardSpeed", "rightZero");
+    // Use the velocity tables for proportional correction when available
+    float velocity;
+    if (cruiseVelocity(leftForwardSpeed, rightForwardSpeed, velocity))
+    {
+        driveVelocity(velocity, total);
+        return;
+    }
+    float gyroX = 0;
     // Create a smart pointer to a new GyroHelper object. Smart pointer aids in deallocation
-    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050));
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config, simulator));
     int leftSpeed;
     int rightSpeed;
+    float trim = 0;
     long start = millis();
     // Keep driving until time limit is reached
     while (millis() - start < total)
     {
         gyroX = helper->getAngle();
-        /*
-         * Check if the robot has drifted of course using the gyro.
-         * If it has, then increase the speed of one wheel until the
-         * robot is back on course.
-         */
-        if (gyroX > config->TunableBotSettings["drift"].value)
-        {
-            rightSpeed = config->TunableBotSettings["rightForwardSpeed"].value - config->TunableBotSettings["driftBoost"].value;
-            leftSpeed = config->TunableBotSettings["leftForwardSpeed"].value;
-        }
-        else if (gyroX < -config->TunableBotSettings["drift"].value)
-        {
-            rightSpeed = config->TunableBotSettings["rightForwardSpeed"].value;
-            leftSpeed = config->TunableBotSettings["leftForwardSpeed"].value + config->TunableBotSettings["driftBoost"].value;
-        }
-        else
+        // A positive heading means the left wheel is ahead, so slow it, otherwise slow the right wheel
+        float correction = driftCorrection(gyroX, trim);
+        leftSpeed = slowed(leftForwardSpeed, "leftZero", correction);
+        rightSpeed = slowed(rightForwardSpeed, "rightZero", -correction);
+        // Set the motors to the appropriate speed
         {
-            rightSpeed = config->TunableBotSettings["rightForwardSpeed"].value;
-            leftSpeed = config->TunableBotSettings["leftForwardSpeed"].value;
+            PROFILE_SCOPE("Servo write forward");
+            writeServos(leftSpeed, rightSpeed);
         }
-        // Set the motors to the appropriate speed
-        left.write(leftSpeed);
-        right.write(rightSpeed);
+        telemetry->updateMotion(gyroX, helper->getRate(), leftSpeed, rightSpeed);
         delay(50);
     }
     // Stop motors
-    left.write(config->TunableBotSettings["leftZero"].value);
-    right.write(config->TunableBotSettings["rightZero"].value);
+    writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+    telemetry->updateMotion(gyroX, helper->getRate(), servoCommands[0], servoCommands[1]);
 }
 
 /// @brief Called when the robot needs to drive backward
 /// @param magnitude How many spaces to cover
 void RuckusBot::driveBackward(int magnitude)
 {
-    Serial.println("Moving backward");
+    Logger::info("Moving backward");
     // Calculate total time needed for the move
-    int total = config->TunableBotSettings["linearTime"].value * magnitude;
-    float gyroX;
+    int total = config->TunableBotSettings["linearTime"].value * magnitude * battery->timeScale();
+    int leftBackwardSpeed = compensated("leftBackwardSpeed", "leftZero");
+    int rightBackwardSpeed = compensated("rightBackwardSpeed", "rightZero");
+    // Use the velocity tables for proportional correction when available
+    float velocity;
+    if (cruiseVelocity(leftBackwardSpeed, rightBackwardSpeed, velocity))
+    {
+        driveVelocity(velocity, total);
+        return;
+    }
+    float gyroX = 0;
     // Create a smart pointer to a new GyroHelper object. Smart pointer aids in deallocation
-    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050));
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config, simulator));
     int leftSpeed;
     int rightSpeed;
+    float trim = 0;
     long start = millis();
     // Keep driving until time limit is reached
     while (millis() - start < total)
     {
         gyroX = helper->getAngle();
-        /*
-         * Check if the robot has drifted of course using the gyro.
-         * If it has, then increase the speed of one wheel until the
-         * robot is back on course.
-         */
-        if (gyroX > config->TunableBotSettings["drift"].value)
+        // Driving backward a positive heading means the right wheel is ahead
+        float correction = driftCorrection(gyroX, trim);
+        leftSpeed = slowed(leftBackwardSpeed, "leftZero", -correction);
+        rightSpeed = slowed(rightBackwardSpeed, "rightZero", correction);
+        // Set the motors to the appropriate speed
+        {
+            PROFILE_SCOPE("Servo write backward");
+            writeServos(leftSpeed, rightSpeed);
+        }
+        telemetry->updateMotion(gyroX, helper->getRate(), leftSpeed, rightSpeed);
+        delay(50);
+    }
+    // Stop the motors
+    writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+    telemetry->updateMotion(gyroX, helper->getRate(), servoCommands[0], servoCommands[1]);
+}
+
+/// @brief Works out how much to slow the wheel that's ahead while driving straight.
+/// The correction is the drift boost for each drift limit of heading error, plus a trim that builds up
+/// while the robot stays off course so a steady speed mismatch between the wheels is taken out.
+/// @param heading The heading error in degrees.
+/// @param trim The accumulated trim, updated for one 50ms control step.
+/// @return The correction in servo command degrees, positive to slow the left wheel when driving forward.
+float RuckusBot::driftCorrection(float heading, float& trim)
+{
+    float gain = config->TunableBotSettings["driftBoost"].value / max(config->TunableBotSettings["drift"].value, 1.0f);
+    trim += heading * 0.05 / DriftTrimTime;
+    return gain * (heading + trim);
+}
+
+/// @brief Moves a servo command towards its stopped point without passing it.
+/// @param command The servo command in degrees.
+/// @param zero The setting with the wheel's stopped point.
+/// @param amount How far to move the command in degrees, nothing if negative.
+/// @return The slowed servo command in degrees.
+int RuckusBot::slowed(int command, const char* zero, float amount)
+{
+    float stopped = config->TunableBotSettings[zero].value;
+    amount = constrain(amount, 0.0f, abs(command - stopped));
+    return command > stopped ? command - amount : command + amount;
+}
+
+/// @brief Sends commands to the servos, or to the simulator while replaying.
+/// @param leftCommand The left servo command, in degrees or in microseconds if 500 or more.
+/// @param rightCommand The right servo command, in degrees or in microseconds if 500 or more.
+void RuckusBot::writeServos(int leftCommand, int rightCommand)
+{
+    servoCommands[0] = leftCommand;
+    servoCommands[1] = rightCommand;
+    if (simulator != NULL)
+    {
+        simulator->command(leftCommand, rightCommand);
+        return;
+    }
+    // Commands of 500 or more are treated as pulse widths by the servo library
+    left.write(leftCommand);
+    right.write(rightCommand);
+}
+
+/// @brief Gets a speed setting scaled about the stopped point to make up for the battery voltage.
+/// @param speed The speed setting.
+/// @param zero The setting with the wheel's stopped point.
+/// @return The servo command in degrees.
+int RuckusBot::compensated(const char* speed, const char* zero)
+{
+    float stopped = config->TunableBotSettings[zero].value;
+    return constrain(stopped + (config->TunableBotSettings[speed].value - stopped) * battery->speedScale(), 0.0f, 180.0f);
+}
+
+/// @brief Finds a velocity both wheels can reach from the speed settings, using the velocity tables.
+/// @param leftCommand The left servo command in degrees.
+/// @param rightCommand The right servo command in degrees, negated if the wheels should turn in opposite directions.
+/// @param velocity Receives the left wheel velocity, the slower of the two wheels' velocities.
+/// @return True if the velocity tables are available and both wheels move in the same direction.
+bool RuckusBot::cruiseVelocity(float leftCommand, float rightCommand, float& velocity)
+{
+    if (!config->hasVelocityTables())
+    {
+        return false;
+    }
+    float sign = rightCommand < 0 ? -1 : 1;
+    // Servo commands in degrees map linearly to pulse widths of 500 to 2500us
+    float leftVelocity = config->pulseToVelocity(Configuration::LeftWheel, 500 + leftCommand * 2000 / 180);
+    float rightVelocity = sign * config->pulseToVelocity(Configuration::RightWheel, 500 + abs(rightCommand) * 2000 / 180);
+    if (leftVelocity * rightVelocity <= 0)
+    {
+        return false;
+    }
+    velocity = leftVelocity > 0 ? min(leftVelocity, rightVelocity) : max(leftVelocity, rightVelocity);
+    return true;
+}
+
+/// @brief Drives straight at a wheel velocity, correcting heading error proportionally through the velocity tables.
+/// @param velocity The wheel velocity, negative to drive backward.
+/// @param total How long to drive for in milliseconds.
+void RuckusBot::driveVelocity(float velocity, int total)
+{
+    float gyroX = 0;
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config, simulator));
+    int leftPulse;
+    int rightPulse;
+    long start = millis();
+    while (millis() - start < total)
+    {
+        gyroX = helper->getAngle();
+        // A positive heading means the left wheel is running faster than the right, in either direction
+        float correction = gyroX * HeadingGain;
+        leftPulse = config->velocityToPulse(Configuration::LeftWheel, velocity - correction);
+        rightPulse = config->velocityToPulse(Configuration::RightWheel, velocity + correction);
         {
-            rightSpeed = config->TunableBotSettings["rightBackwardSpeed"].value;
-            leftSpeed = config->TunableBotSettings["leftBackwardSpeed"].value - config->TunableBotSettings["driftBoost"].value;
+            PROFILE_SCOPE("Servo write velocity");
+            writeServos(leftPulse, rightPulse);
         }
-        else if (gyroX < (0 - config->TunableBotSettings["drift"].value))
+        telemetry->updateMotion(gyroX, helper->getRate(), leftPulse, rightPulse);
+        delay(20);
+    }
+    // Stop motors
+    writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+    telemetry->updateMotion(gyroX, helper->getRate(), servoCommands[0], servoCommands[1]);
+}
+
+/// @brief Measures each wheel's velocity across a range of pulse widths and saves the results as velocity tables.
+/// Each wheel is run alone so the robot pivots on the other, making the yaw rate proportional to the wheel's velocity.
+/// @return True on success.
+bool RuckusBot::identifyServos()
+{
+    Serial.println("Identifying servos");
+    unsigned long start = millis();
+    bool success = true;
+    for (int wheel = 0; wheel < 2; wheel++)
+    {
+        bool leftWheel = wheel == Configuration::LeftWheel;
+        int otherZero = config->TunableBotSettings[leftWheel ? "rightZero" : "leftZero"].value;
+        float velocity[Configuration::VelocityPoints];
+        float pulse[Configuration::VelocityPoints];
+        for (int i = 0; i < Configuration::VelocityPoints; i++)
         {
-            rightSpeed = config->TunableBotSettings["rightBackwardSpeed"].value + config->TunableBotSettings["driftBoost"].value;
-            leftSpeed = config->TunableBotSettings["leftBackwardSpeed"].value;
+            pulse[i] = 1100 + i * 800 / (Configuration::VelocityPoints - 1);
+            // Commands of 500 or more are treated as pulse widths by the servo library
+            float rate = measureRate(leftWheel ? pulse[i] : otherZero, leftWheel ? otherZero : pulse[i], 300, i == Configuration::VelocityPoints - 1);
+            // The robot yaws positive when the left wheel goes forward or the right wheel goes backward
+            velocity[i] = leftWheel ? rate : -rate;
         }
-        else
+        // Keep the points strictly increasing in velocity and monotonic in pulse width so the table can be inverted, which merges the deadband into a single point
+        float direction = velocity[Configuration::VelocityPoints - 1] >= velocity[0] ? 1 : -1;
+        float sortedVelocity[Configuration::VelocityPoints];
+        float sortedPulse[Configuration::VelocityPoints];
+        int count = 0;
+        for (int i = 0; i < Configuration::VelocityPoints; i++)
         {
-            rightSpeed = config->TunableBotSettings["rightBackwardSpeed"].value;
-            leftSpeed = config->TunableBotSettings["leftBackwardSpeed"].value;
+            int j = direction > 0 ? i : Configuration::VelocityPoints - 1 - i;
+            if (count == 0 || velocity[j] > sortedVelocity[count - 1] + StoppedRate)
+            {
+                sortedVelocity[count] = velocity[j];
+                sortedPulse[count] = pulse[j];
+                count++;
+            }
         }
-        // Set the motors to the appropriate speed
-        left.write(leftSpeed);
-        right.write(rightSpeed);
-        delay(50);
+        success &= config->setVelocityTable((Configuration::Wheels)wheel, sortedVelocity, sortedPulse, count);
     }
-    // Stop the motors
-    left.write(config->TunableBotSettings["leftZero"].value);
-    right.write(config->TunableBotSettings["rightZero"].value);
+    Serial.printf("Servo identification took %lums\n", millis() - start);
+    return success;
 }
 
 /// @brief Called when a robot is told to move, but is blocked
@@ -325,7 +535,7 @@ void RuckusBot::blockedMove()
 /// @param amount Total damage taken so far.
 void RuckusBot::takeDamage(int amount)
 {
-    Serial.print(amount);
+    Logger::info("Damage %d", amount);
     showImage(images::Surprised, (colors)config->TunableBotSettings["robotColor"].value);
     delay(1000);
     showImage((images)config->BotConfig.PlayerNumber, (colors)config->TunableBotSettings["robotColor"].value);
@@ -352,6 +562,116 @@ void RuckusBot::speedTest()
     driveBackward(3);
 }
 
+/// @brief Finds each wheel's stopped point and matches the wheel speeds for straight travel by measuring yaw with the gyro.
+/// The robot drives short distances forward and backward, so it needs about half a metre of clear space.
+void RuckusBot::autoCalibrate()
+{
+    Serial.println("Calibrating servos");
+    unsigned long start = millis();
+    Calibration.complete = false;
+    // Find the deadband of each wheel by running it alone, the robot pivots on the other wheel
+    findDeadband(true, config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value, Calibration.leftZero, Calibration.leftDeadband);
+    findDeadband(false, config->TunableBotSettings["rightZero"].value, Calibration.leftZero, Calibration.rightZero, Calibration.rightDeadband);
+    config->updateSetting("leftZero", Calibration.leftZero);
+    config->updateSetting("rightZero", Calibration.rightZero);
+    // Match the right wheel to the left going forward and the left wheel to the right going backward
+    Calibration.rightForwardSpeed = config->TunableBotSettings["rightForwardSpeed"].value;
+    Calibration.leftBackwardSpeed = config->TunableBotSettings["leftBackwardSpeed"].value;
+    for (int step = 8; step > 0; step /= 2)
+    {
+        // Alternating directions keeps the robot near where it started
+        float forward = measureRate(config->TunableBotSettings["leftForwardSpeed"].value, Calibration.rightForwardSpeed, 600);
+        // Turning positive means the right wheel is slow, lower values are faster forward for the right wheel
+        Calibration.rightForwardSpeed += forward > 0 ? -step : step;
+        float backward = measureRate(Calibration.leftBackwardSpeed, config->TunableBotSettings["rightBackwardSpeed"].value, 600);
+        // Turning positive means the left wheel is slow, lower values are faster backward for the left wheel
+        Calibration.leftBackwardSpeed += backward > 0 ? -step : step;
+    }
+    // Keep the speeds on the moving side of the deadband
+    Calibration.rightForwardSpeed = constrain(Calibration.rightForwardSpeed, 0, Calibration.rightZero - Calibration.rightDeadband / 2 - 1);
+    Calibration.leftBackwardSpeed = constrain(Calibration.leftBackwardSpeed, 0, Calibration.leftZero - Calibration.leftDeadband / 2 - 1);
+    config->updateSetting("rightForwardSpeed", Calibration.rightForwardSpeed);
+    config->updateSetting("leftBackwardSpeed", Calibration.leftBackwardSpeed);
+    // Check the result
+    Calibration.forwardDrift = measureRate(config->TunableBotSettings["leftForwardSpeed"].value, config->TunableBotSettings["rightForwardSpeed"].value, 1000);
+    Calibration.backwardDrift = measureRate(config->TunableBotSettings["leftBackwardSpeed"].value, config->TunableBotSettings["rightBackwardSpeed"].value, 1000);
+    writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+    Calibration.duration = millis() - start;
+    Calibration.complete = true;
+    Serial.println("Calibration complete: " + getCalibration());
+}
+
+/// @brief Gets the results of the last automatic calibration.
+/// @return A JSON string of the calibration results.
+String RuckusBot::getCalibration()
+{
+    char json[256];
+    snprintf(json, sizeof(json), "{\"complete\":%s,\"duration\":%lu,\"leftZero\":%d,\"rightZero\":%d,\"leftDeadband\":%d,\"rightDeadband\":%d,\"rightForwardSpeed\":%d,\"leftBackwardSpeed\":%d,\"forwardDrift\":%.2f,\"backwardDrift\":%.2f}",
+        Calibration.complete ? "true" : "false", Calibration.duration, Calibration.leftZero, Calibration.rightZero, Calibration.leftDeadband, Calibration.rightDeadband,
+        Calibration.rightForwardSpeed, Calibration.leftBackwardSpeed, Calibration.forwardDrift, Calibration.backwardDrift);
+    return String(json);
+}
+
+/// @brief Runs the servos and measures the average yaw rate.
+/// @param leftCommand The left servo command, in degrees or in microseconds if 500 or more.
+/// @param rightCommand The right servo command, in degrees or in microseconds if 500 or more.
+/// @param duration How long to measure for in milliseconds, after letting the servos settle.
+/// @param stop Stop the servos afterwards.
+/// @return The average yaw rate in degrees per second.
+float RuckusBot::measureRate(int leftCommand, int rightCommand, int duration, bool stop)
+{
+    writeServos(leftCommand, rightCommand);
+    delay(200);
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config, simulator));
+    long start = millis();
+    float angle = 0;
+    while (millis() - start < duration)
+    {
+        delay(10);
+        angle = helper->getAngle();
+        telemetry->updateMotion(angle, helper->getRate(), leftCommand, rightCommand);
+    }
+    float rate = angle * 1000 / (millis() - start);
+    if (stop)
+    {
+        writeServos(config->TunableBotSettings["leftZero"].value, config->TunableBotSettings["rightZero"].value);
+        delay(200);
+    }
+    return rate;
+}
+
+/// @brief Sweeps one wheel through commands around its zero point to find where it actually stops.
+/// @param leftWheel True to sweep the left wheel, false for the right.
+/// @param center The command to sweep around.
+/// @param otherZero The command that stops the other wheel.
+/// @param zero Receives the centre of the deadband, or center if none was found.
+/// @param width Receives the width of the deadband.
+void RuckusBot::findDeadband(bool leftWheel, int center, int otherZero, int& zero, int& width)
+{
+    int low = -1;
+    int high = -1;
+    for (int command = max(center - 20, 0); command <= min(center + 20, 180); command++)
+    {
+        float rate = measureRate(leftWheel ? command : otherZero, leftWheel ? otherZero : command, 250, false);
+        if (abs(rate) < StoppedRate)
+        {
+            if (low < 0)
+            {
+                low = command;
+            }
+            high = command;
+        }
+        else if (low >= 0)
+        {
+            // Moving again on the far side of the deadband
+            break;
+        }
+    }
+    writeServos(leftWheel ? center : otherZero, leftWheel ? otherZero : center);
+    zero = low >= 0 ? (low + high) / 2 : center;
+    width = low >= 0 ? high - low + 1 : 0;
+}
+
 /// @brief Runs a navigation test to see how the robot performs
 void RuckusBot::navigationTest()
 {
@@ -407,11 +727,191 @@ void RuckusBot::showIP()
     }
 }
 
-/// @brief Calibrates the gyroscope offsets
+/// @brief Runs the motion code against a simulator instead of the servos and gyro.
+/// @param model The simulator, NULL to use the hardware again.
+void RuckusBot::simulate(Simulator* model)
+{
+    simulator = model;
+}
+
+/// @brief Calibrates the gyroscope offsets and saves them for the next boot
 void RuckusBot::calibrateGyro()
 {
     mpu6050.calcGyroOffsets(true, 2000, 1000);
     Serial.println("");
+    mpu6050.update();
+    float offsets[3] = { mpu6050.getGyroXoffset(), mpu6050.getGyroYoffset(), mpu6050.getGyroZoffset() };
+    config->setGyroCalibration(offsets, mpu6050.getTemp());
+    // Each calibration is also a point on the bias versus temperature model
+    config->addGyroBiasSample(mpu6050.getTemp(), offsets[0]);
+    lastBiasTemperature = mpu6050.getTemp();
+}
+
+/// @brief Adds a point to the gyro bias model if the robot is still and has warmed up since the last one.
+/// Call only from the command processor task while the robot is idle, it takes about half a second.
+void RuckusBot::sampleGyroBias()
+{
+    // This also holds off the first sample until long after the boot calibration
+    if (millis() - lastBiasSample < BiasSamplePeriod)
+    {
+        return;
+    }
+    lastBiasSample = millis();
+    mpu6050.update();
+    float temperature = mpu6050.getTemp();
+    if (abs(temperature - lastBiasTemperature) < 1)
+    {
+        return;
+    }
+    float sum = 0;
+    float peak = 0;
+    for (int i = 0; i < StillnessSamples; i++)
+    {
+        mpu6050.update();
+        sum += mpu6050.getGyroX();
+        peak = max(peak, (float)abs(mpu6050.getGyroX()));
+        delay(2);
+    }
+    // Skip the sample if the robot was being handled
+    if (peak - abs(sum / StillnessSamples) > GyroStillPeak)
+    {
+        return;
+    }
+    // The bias is the offset already removed plus what's left over
+    float bias = mpu6050.getGyroXoffset() + sum / StillnessSamples;
+    config->addGyroBiasSample(temperature, bias);
+    lastBiasTemperature = temperature;
+    Logger::info("Gyro bias %.3f degrees/s at %.1fC", bias, temperature);
+}
+
+/// @brief Measures the heading drift of the robot at rest, with and without the gyro bias model.
+/// The first measurement is kept as the cold drift and the latest as the warm drift.
+/// @param duration How long to measure for in milliseconds.
+void RuckusBot::measureDrift(int duration)
+{
+    Logger::info("Measuring heading drift for %dms, keep the robot still", duration);
+    std::unique_ptr<GyroHelper> helper(new GyroHelper(mpu6050, config));
+    float uncompensated = 0;
+    float angle = 0;
+    unsigned long start = millis();
+    unsigned long previous = start;
+    while (millis() - start < duration)
+    {
+        delay(20);
+        angle = helper->getAngle();
+        // The helper just updated the sensor, so this is the same reading without the bias model
+        uncompensated += mpu6050.getGyroX() * (millis() - previous) * 0.001;
+        previous = millis();
+        telemetry->updateMotion(angle, helper->getRate(), servoCommands[0], servoCommands[1]);
+    }
+    float minutes = (millis() - start) / 60000.0;
+    DriftMeasurement measurement = { true, mpu6050.getTemp(), angle / minutes, uncompensated / minutes };
+    if (!coldDrift.measured)
+    {
+        coldDrift = measurement;
+    }
+    warmDrift = measurement;
+    Logger::info("Heading drift at %.1fC: %.2f degrees/minute compensated, %.2f uncompensated", measurement.temperature, measurement.compensated, measurement.uncompensated);
+}
+
+/// @brief Retrieves the heading drift measurements and the gyro bias model.
+/// @return A JSON string of the current temperature, the cold and warm drift in degrees per minute, and the model.
+String RuckusBot::getGyroDrift()
+{
+    JsonDocument drift_doc;
+    drift_doc["temperature"] = mpu6050.getTemp();
+    const DriftMeasurement* measurements[2] = { &coldDrift, &warmDrift };
+    const char* names[2] = { "cold", "warm" };
+    for (int i = 0; i < 2; i++)
+    {
+        if (measurements[i]->measured)
+        {
+            JsonObject measurement = drift_doc[names[i]].to<JsonObject>();
+            measurement["temperature"] = measurements[i]->temperature;
+            measurement["compensated"] = measurements[i]->compensated;
+            measurement["uncompensated"] = measurements[i]->uncompensated;
+        }
+    }
+    JsonDocument model_doc;
+    deserializeJson(model_doc, config->getGyroBiasModel());
+    drift_doc["model"] = model_doc;
+    String drift_string;
+    serializeJson(drift_doc, drift_string);
+    return drift_string;
+}
+
+/// @brief Waits for the gyro calibration started by begin() to finish.
+void RuckusBot::waitForGyro()
+{
+    xSemaphoreTake(gyroReady, portMAX_DELAY);
+    // Leave it available for any other waiters
+    xSemaphoreGive(gyroReady);
+}
+
+/// @brief Wraps the gyro calibration task for static access.
+/// @param arg The RuckusBot object.
+void RuckusBot::GyroTaskWrapper(void* arg)
+{
+    static_cast<RuckusBot*>(arg)->GyroTask();
+}
+
+/// @brief Reuses the saved gyro offsets if they're still good, otherwise calibrates, then ends.
+void RuckusBot::GyroTask()
+{
+    if (restoreGyroCalibration())
+    {
+        BootTimeline::mark("Gyro offsets restored");
+    }
+    else
+    {
+        calibrateGyro();
+        BootTimeline::mark("Gyro calibrated");
+    }
+    xSemaphoreGive(gyroReady);
+    vTaskDelete(NULL);
+}
+
+/// @brief Applies the saved gyro offsets if the sensor is near the temperature they were measured at and the robot is still.
+/// @return True if the saved offsets were applied.
+bool RuckusBot::restoreGyroCalibration()
+{
+    float offsets[3];
+    float temperature;
+    if (!config->getGyroCalibration(offsets, temperature))
+    {
+        Logger::info("No saved gyro offsets");
+        return false;
+    }
+    mpu6050.setGyroOffsets(offsets[0], offsets[1], offsets[2]);
+    mpu6050.update();
+    if (abs(mpu6050.getTemp() - temperature) > GyroTemperatureTolerance)
+    {
+        Logger::info("Gyro is %.1fC from its saved offsets, recalibrating", mpu6050.getTemp() - temperature);
+        return false;
+    }
+    // With the saved offsets applied a still robot reads close to zero on every axis
+    float sums[3] = { 0, 0, 0 };
+    float peak = 0;
+    for (int i = 0; i < StillnessSamples; i++)
+    {
+        mpu6050.update();
+        float rates[3] = { mpu6050.getGyroX(), mpu6050.getGyroY(), mpu6050.getGyroZ() };
+        for (int axis = 0; axis < 3; axis++)
+        {
+            sums[axis] += rates[axis];
+            peak = max(peak, (float)abs(rates[axis]));
+        }
+        delay(2);
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (abs(sums[axis] / StillnessSamples) > GyroStillRate || peak > GyroStillPeak)
+        {
+            Logger::info("Robot moving or gyro offsets stale (axis %d averaged %.2f, peak %.2f degrees/s), recalibrating", axis, sums[axis] / StillnessSamples, peak);
+            return false;
+        }
+    }
+    return true;
 }
 
 /// @brief Displays an image on the LED screen. Adapted from https://www.elecrow.com/wiki/index.php?title=Mbits#Use_with_Mbits-RGB_Matrix
@@ -419,6 +919,7 @@ void RuckusBot::calibrateGyro()
 /// @param myRGBcolor The color to use
 void RuckusBot::Display(uint8_t dat[], CRGB myRGBcolor)
 {
+    PROFILE_SCOPE("LED display");
     for (int c = 0; c < 5; c++)
     {
         for (int r = 0; r < 5; r++)
@@ -437,6 +938,7 @@ void RuckusBot::Display(uint8_t dat[], CRGB myRGBcolor)
 /// @param myRGBcolor The color to use
 void RuckusBot::showColor(CRGB myRGBcolor)
 {
+    PROFILE_SCOPE("LED color");
     for (int i = 0; i < frontLED.len; i++)
     {
         frontLED[i] = myRGBcolor;
@@ -37,9 +37,20 @@
 #include <ESP32Servo.h>
 #include <Configuration.h>
 #include <HTTPCommunication.h>
+#include <Telemetry.h>
+#include <Battery.h>
+#include <Profiler.h>
+#include <Logger.h>
+#include <Simulator.h>
+#include <BootTimeline.h>
+#include <WarmRestart.h>
 
 class RuckusBot 
 {
+    #ifdef RUCKUS_BENCHMARK
+    friend class Benchmark;
+    #endif
+
     private:
         // Robot pins
         #define FRONT_LEDS_PIN  26
@@ -55,6 +66,12 @@ class RuckusBot
          /// @brief A reference to the shared configuration object.
         HTTPCommunication* communication;
 
+        /// @brief A reference to the shared telemetry object.
+        Telemetry* telemetry;
+
+        /// @brief A reference to the shared battery monitor.
+        Battery* battery;
+
         /// @brief Helper class for getting angle robot has turned.
         /// Used because the MPU6050 library gyroAngle can't
         /// be reset without calling begin() method again.    
@@ -62,30 +79,59 @@ class RuckusBot
             public:
             /// @brief  Initialize the helper using a the specific sensor
             /// @param Gyro The senor to use
-            GyroHelper(MPU6050 &Gyro) : gyro(Gyro) {
+            /// @param Config The configuration holding the gyro bias model
+            /// @param Model A simulator to read instead of the sensor, NULL to use the sensor
+            GyroHelper(MPU6050 &Gyro, Configuration* Config, Simulator* Model = NULL) : gyro(Gyro), config(Config), model(Model) {
                 previousTime = millis();
-                gyro.update();        
+                if (model == NULL)
+                {
+                    gyro.update();
+                }
             }
 
             /// @brief Get the angle turned since last called
             /// @return Float of the degrees turned since last call
             float getAngle() {
-                gyro.update();
-                // Get rotation in deg/s
-                float gyroX = gyro.getGyroX();
+                if (model != NULL)
+                {
+                    rate = model->readGyro();
+                }
+                else
+                {
+                    {
+                        PROFILE_SCOPE("Gyro update");
+                        gyro.update();
+                    }
+                    // Get rotation in deg/s
+                    rate = gyro.getGyroX();
+                    // Remove the change in bias since the offsets were set as the sensor warms up
+                    if (config->hasGyroBiasModel())
+                    {
+                        rate -= config->gyroBias(gyro.getTemp()) - gyro.getGyroXoffset();
+                    }
+                }
                 // Calculate time since last call in seconds
                 interval = (millis() - previousTime) * 0.001;
                 previousTime = millis();
                 // Calculate total degrees turned so far
-                totalAngle += gyroX * interval;
+                totalAngle += rate * interval;
                 // Return total angle turned
                 return totalAngle;
             }
 
+            /// @brief Get the rotation rate measured by the last call to getAngle
+            /// @return Float of the rotation rate in degrees per second
+            float getRate() {
+                return rate;
+            }
+
             private:
             MPU6050 &gyro;
+            Configuration* config;
+            Simulator* model;
             long previousTime;
             float interval = 0;
+            float rate = 0;
             float totalAngle = 0;
         };
 
@@ -105,8 +151,28 @@ class RuckusBot
         /// @brief Turn direction
         enum turnType { Left, Right };
 
+        /// @brief Results of the last automatic calibration.
+        struct CalibrationResult
+        {
+            /// @brief True once a calibration has finished.
+            bool complete;
+            /// @brief Time taken in milliseconds.
+            unsigned long duration;
+            /// @brief Centre of each wheel's deadband, in degrees.
+            int leftZero, rightZero;
+            /// @brief Width of each wheel's deadband, in degrees.
+            int leftDeadband, rightDeadband;
+            /// @brief Matched speeds, in degrees.
+            int rightForwardSpeed, leftBackwardSpeed;
+            /// @brief Heading drift driving straight with the calibrated settings, in degrees per second.
+            float forwardDrift, backwardDrift;
+        };
+
+        /// @brief Results of the last automatic calibration.
+        CalibrationResult Calibration = { false, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
         // Public methods
-        RuckusBot(Configuration* Config, HTTPCommunication* Communication);
+        RuckusBot(Configuration* Config, HTTPCommunication* Communication, Telemetry* Telem, Battery* Batt);
         void begin();
         void playerAssigned(int player);
         void showImage(images image, colors color, bool cache = true);
@@ -117,13 +183,22 @@ class RuckusBot
         void blockedMove();
         void takeDamage(int amount);
         void speedTest();
+        void autoCalibrate();
+        bool identifyServos();
+        String getCalibration();
         void navigationTest();
         void reset();
         void setup(bool enable);
         void showIP();
         void calibrateGyro();
+        void waitForGyro();
+        void sampleGyroBias();
+        void measureDrift(int duration);
+        String getGyroDrift();
+        static void GyroTaskWrapper(void* arg);
         void ready();
         void notReady();
+        void simulate(Simulator* model);
 
     private:
         CRGBArray<25> leds;
@@ -168,7 +243,75 @@ class RuckusBot
             CRGB(144, 144, 128) // White
         };
 
+        /// @brief Simulator receiving servo commands and supplying gyro readings instead of the hardware, NULL when not replaying.
+        Simulator* simulator = NULL;
+
+        /// @brief The last left and right servo commands written.
+        int servoCommands[2] = { 0, 0 };
+
+        /// @brief Heading drift of the robot at rest.
+        struct DriftMeasurement
+        {
+            /// @brief True once measured.
+            bool measured;
+            /// @brief Sensor temperature in degrees Celsius.
+            float temperature;
+            /// @brief Drift with the bias model applied, in degrees per minute.
+            float compensated;
+            /// @brief Drift with only the calibrated offsets, in degrees per minute.
+            float uncompensated;
+        };
+
+        /// @brief The first drift measurement since boot, with the sensor cold.
+        DriftMeasurement coldDrift = { false, 0, 0, 0 };
+
+        /// @brief The latest drift measurement.
+        DriftMeasurement warmDrift = { false, 0, 0, 0 };
+
+        /// @brief Time of the last idle gyro bias sample attempt in milliseconds.
+        unsigned long lastBiasSample = 0;
+
+        /// @brief Temperature of the last gyro bias sample in degrees Celsius.
+        float lastBiasTemperature = -100;
+
+        /// @brief Time between idle gyro bias samples in milliseconds.
+        static const unsigned long BiasSamplePeriod = 60000;
+
+        /// @brief Given once the boot gyro calibration has finished.
+        SemaphoreHandle_t gyroReady;
+
+        /// @brief Largest temperature change in degrees Celsius for saved gyro offsets to be reused.
+        static constexpr float GyroTemperatureTolerance = 4;
+
+        /// @brief Largest average rate on any axis in degrees per second, with the saved offsets applied, for the robot to be considered still.
+        static constexpr float GyroStillRate = 0.5;
+
+        /// @brief Largest single rate reading in degrees per second for the robot to be considered still.
+        static constexpr float GyroStillPeak = 3;
+
+        /// @brief Gyro readings taken to check the robot is still.
+        static const int StillnessSamples = 200;
+
+        /// @brief Yaw rate in degrees per second below which a wheel is considered stopped.
+        static constexpr float StoppedRate = 3;
+
+        /// @brief Wheel velocity correction per degree of heading error when driving with the velocity tables.
+        static constexpr float HeadingGain = 4;
+
+        /// @brief Time in seconds for the drift trim to match the correction of a steady heading error.
+        static constexpr float DriftTrimTime = 0.5;
+
         String getValue(String data, char separator, int index);
+        void GyroTask();
+        bool restoreGyroCalibration();
+        void writeServos(int leftCommand, int rightCommand);
+        int compensated(const char* speed, const char* zero);
+        float driftCorrection(float heading, float& trim);
+        int slowed(int command, const char* zero, float amount);
+        bool cruiseVelocity(float leftCommand, float rightCommand, float& velocity);
+        void driveVelocity(float velocity, int total);
+        float measureRate(int leftCommand, int rightCommand, int duration, bool stop = true);
+        void findDeadband(bool leftWheel, int center, int otherZero, int& zero, int& width);
         void Display(uint8_t dat[], CRGB myRGBcolor);
         void showColor(CRGB myRGBcolor);      
 };
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "Simulator.h"
+#include <RuckusBot.h>
+
+/// @brief Creates a simulator.
+/// @param Config A reference to the shared configuration object.
+/// @param Recorder A reference to the flight recorder, used for recorded gyro noise.
+Simulator::Simulator(Configuration* Config, FlightRecorder* Recorder)
+{
+    config = Config;
+    recorder = Recorder;
+}
+
+/// @brief Runs replay scenarios through the robot's motion code. Call only from the command processor task while the robot is stopped.
+/// @param bot The robot whose motion code is replayed.
+/// @param scenarios A JSON array of scenarios, empty for the built in set.
+/// @return True if every scenario passed.
+bool Simulator::run(RuckusBot* bot, String scenarios)
+{
+    complete = false;
+    if (!parse(scenarios))
+    {
+        return false;
+    }
+    Logger::info("Replaying %d scenarios", count);
+    // Copy the noise first, since the replayed moves are recorded too
+    loadNoise();
+    for (int i = 0; i < count; i++)
+    {
+        results[i] = runScenario(bot, this->scenarios[i]);
+    }
+    complete = true;
+    Logger::info("Replay %s", passed() ? "passed" : "FAILED");
+    return passed();
+}
+
+/// @brief Gets the results of the last run.
+/// @return A JSON string of the results.
+String Simulator::getResults()
+{
+    JsonDocument results_doc;
+    results_doc["passed"] = passed();
+    JsonArray scenario_results = results_doc["scenarios"].to<JsonArray>();
+    for (int i = 0; i < count && complete; i++)
+    {
+        JsonObject result = scenario_results.add<JsonObject>();
+        result["name"] = scenarios[i].name;
+        result["headingError"] = results[i].headingError;
+        result["deviation"] = results[i].deviation;
+        result["time"] = results[i].time;
+        result["jitter"] = results[i].jitter;
+        result["commands"] = results[i].commands;
+        result["passed"] = results[i].passed;
+    }
+    String results_string;
+    serializeJson(results_doc, results_string);
+    return results_string;
+}
+
+/// @brief Checks if every scenario of the last run passed.
+/// @return True if all passed.
+bool Simulator::passed()
+{
+    for (int i = 0; i < count && complete; i++)
+    {
+        if (!results[i].passed)
+        {
+            return false;
+        }
+    }
+    return complete;
+}
+
+/// @brief Receives servo commands in place of the servos while a scenario runs.
+/// @param leftCommand The left servo command, in degrees or in microseconds if 500 or more.
+/// @param rightCommand The right servo command, in degrees or in microseconds if 500 or more.
+void Simulator::command(int leftCommand, int rightCommand)
+{
+    advance(esp_timer_get_time());
+    float left = toPulse(leftCommand);
+    float right = toPulse(rightCommand);
+    // The first command starts the move, so only changes after it count as jitter
+    if (commands > 0)
+    {
+        lastJitter = (abs(left - pulses[0]) + abs(right - pulses[1])) / 2;
+        jitterSum += lastJitter;
+    }
+    commands++;
+    pulses[0] = left;
+    pulses[1] = right;
+}
+
+/// @brief Reads the modelled gyro in place of the sensor while a scenario runs.
+/// @return The yaw rate in degrees per second, with bias and noise.
+float Simulator::readGyro()
+{
+    advance(esp_timer_get_time());
+    float rate = velocities[0] - velocities[1] + scenario->gyroBias;
+    if (scenario->recordedNoise && noiseCount > 0)
+    {
+        rate += noise[noiseIndex++ % noiseCount];
+    }
+    else
+    {
+        rate += random(-1000, 1001) / 1000.0f * scenario->gyroNoise;
+    }
+    return rate;
+}
+
+/// @brief Reads the scenarios to run.
+/// @param json A JSON array of scenarios, empty for the built in set.
+/// @return True on success.
+bool Simulator::parse(String json)
+{
+    count = 0;
+    if (json == "")
+    {
+        addScenario("straight", 2, 2, 0.05, 0, 60, 1, false);
+        addScenario("reverse", 3, 1, -0.05, 15, 60, 1, false);
+        addScenario("right", 1, 1, 0, 0, 60, 1, false);
+        addScenario("left", 0, 1, 0.05, 0, 60, 1, false);
+        addScenario("uturn", 1, 2, 0, 0, 120, 1, false);
+        addScenario("recorded", 2, 1, 0.03, 0, 60, 0, true);
+        return true;
+    }
+    JsonDocument scenarios_doc;
+    if (deserializeJson(scenarios_doc, json) || !scenarios_doc.is<JsonArray>())
+    {
+        Logger::warning("Bad replay scenarios received");
+        return false;
+    }
+    for (JsonObject scenario : scenarios_doc.as<JsonArray>())
+    {
+        int move = scenario["move"] | 2;
+        int magnitude = scenario["magnitude"] | 1;
+        if (count == MaxScenarios || move < 0 || move > 3 || magnitude < 1 || magnitude > 3)
+        {
+            Logger::warning("Skipping replay scenario, only %d turns or drives of magnitude 1 to 3 are allowed", MaxScenarios);
+            continue;
+        }
+        addScenario(scenario["name"] | "scenario", move, magnitude, scenario["mismatch"] | 0.0f, scenario["zeroError"] | 0.0f,
+            scenario["lag"] | 60.0f, scenario["gyroNoise"] | 1.0f, scenario["recordedNoise"] | false);
+        Scenario& added = scenarios[count - 1];
+        added.deadband = scenario["deadband"] | added.deadband;
+        added.gyroBias = scenario["gyroBias"] | added.gyroBias;
+        added.maxHeadingError = scenario["maxHeadingError"] | added.maxHeadingError;
+        added.maxDeviation = scenario["maxDeviation"] | added.maxDeviation;
+        added.maxJitter = scenario["maxJitter"] | added.maxJitter;
+        added.maxTime = scenario["maxTime"] | added.maxTime;
+    }
+    return count > 0;
+}
+
+/// @brief Adds a scenario with the default deadband, gyro bias and limits.
+/// @param name The scenario name.
+/// @param move The move, numbered as CommandProcessor::Movements.
+/// @param magnitude The move magnitude.
+/// @param mismatch How much faster the left wheel is than the right, as a fraction.
+/// @param zeroError Error in each wheel's stopped point in microseconds.
+/// @param lag Wheel response time constant in milliseconds.
+/// @param gyroNoise Peak synthetic gyro noise in degrees per second.
+/// @param recordedNoise Use the vibration from the last recorded move instead.
+void Simulator::addScenario(const char* name, int move, int magnitude, float mismatch, float zeroError, float lag, float gyroNoise, bool recordedNoise)
+{
+    scenarios[count++] = Scenario
+    {
+        name: name,
+        move: move,
+        magnitude: magnitude,
+        mismatch: mismatch,
+        zeroError: zeroError,
+        deadband: 20,
+        lag: lag,
+        gyroBias: 0.3,
+        gyroNoise: gyroNoise,
+        recordedNoise: recordedNoise,
+        maxHeadingError: 5,
+        maxDeviation: 40,
+        maxJitter: 100,
+        maxTime: (uint32_t)(2500 * magnitude)
+    };
+}
+
+/// @brief Runs one move against the plant model.
+/// @param bot The robot whose motion code is replayed.
+/// @param current The scenario.
+/// @return The measurements.
+Simulator::Result Simulator::runScenario(RuckusBot* bot, Scenario& current)
+{
+    // Start at rest, with the servos at their configured stopped points
+    scenario = &current;
+    pulses[0] = toPulse(config->TunableBotSettings["leftZero"].value);
+    pulses[1] = toPulse(config->TunableBotSettings["rightZero"].value);
+    velocities[0] = velocities[1] = 0;
+    heading = x = y = deviation = 0;
+    jitterSum = lastJitter = 0;
+    commands = 0;
+    noiseIndex = 0;
+    updated = esp_timer_get_time();
+
+    bot->simulate(this);
+    unsigned long start = millis();
+    switch (current.move)
+    {
+        case 0:
+            bot->turn(RuckusBot::turnType::Left, current.magnitude);
+            break;
+        case 1:
+            bot->turn(RuckusBot::turnType::Right, current.magnitude);
+            break;
+        case 2:
+            bot->driveForward(current.magnitude);
+            break;
+        case 3:
+            bot->driveBackward(current.magnitude);
+            break;
+    }
+    uint32_t time = millis() - start;
+    // Let the robot coast to a stop before taking the final heading
+    advance(updated + SettleTime);
+    bot->simulate(NULL);
+
+    float target = current.move == 0 ? -90 * current.magnitude : current.move == 1 ? 90 * current.magnitude : 0;
+    // The stop command isn't jitter either
+    float jitter = commands > 2 ? (jitterSum - lastJitter) / (commands - 2) : 0;
+    Result result { heading - target, deviation, time, jitter, commands, false };
+    result.passed = abs(result.headingError) <= current.maxHeadingError && result.deviation <= current.maxDeviation
+        && result.jitter <= current.maxJitter && result.time <= current.maxTime;
+    Logger::info("Scenario %s: heading error %.1f degrees, deviation %.0fmm, %ums, jitter %.1fus %s", current.name.c_str(),
+        result.headingError, result.deviation, result.time, result.jitter, result.passed ? "passed" : "FAILED");
+    scenario = NULL;
+    return result;
+}
+
+/// @brief Copies the gyro vibration of the last recorded move for replaying as noise.
+void Simulator::loadNoise()
+{
+    float rates[NoiseSamples];
+    int samples = 0;
+    int commandId = -1;
+    FlightRecorder::Record record;
+    // Walk back from the newest sample to the last movement command, then collect its samples
+    for (uint32_t index = recorder->endRecord(); index > 0 && samples < NoiseSamples; index--)
+    {
+        if (!recorder->read(index - 1, record))
+        {
+            break;
+        }
+        if (record.commandType == 0 && (commandId < 0 || record.commandId == commandId))
+        {
+            commandId = record.commandId;
+            rates[samples++] = record.gyroRate;
+        }
+        else if (commandId >= 0)
+        {
+            break;
+        }
+    }
+    // Keep only the vibration by removing a moving average of the turning rate, in time order
+    noiseCount = 0;
+    for (int i = samples - 1; i >= 0; i--)
+    {
+        float sum = 0;
+        int window = 0;
+        for (int j = max(i - 2, 0); j <= min(i + 2, samples - 1); j++)
+        {
+            sum += rates[j];
+            window++;
+        }
+        noise[noiseCount++] = rates[i] - sum / window;
+    }
+    if (noiseCount == 0)
+    {
+        Logger::warning("No recorded move to take gyro noise from, using synthetic noise");
+    }
+}
+
+/// @brief Integrates the plant model up to a time.
+/// @param time The time in microseconds since boot.
+void Simulator::advance(int64_t time)
+{
+    float leftZero = toPulse(config->TunableBotSettings["leftZero"].value) + scenario->zeroError;
+    float rightZero = toPulse(config->TunableBotSettings["rightZero"].value) + scenario->zeroError;
+    // The right servo is mounted mirrored, so it drives forward below its stopped point
+    float targets[2] = { wheelVelocity(pulses[0], leftZero) * (1 + scenario->mismatch), -wheelVelocity(pulses[1], rightZero) };
+    while (updated < time)
+    {
+        float interval = min((int64_t)Step, time - updated) / 1e6f;
+        updated += min((int64_t)Step, time - updated);
+        for (int wheel = 0; wheel < 2; wheel++)
+        {
+            velocities[wheel] += (targets[wheel] - velocities[wheel]) * min(interval * 1000 / scenario->lag, 1.0f);
+        }
+        // Wheel velocities are in degrees per second of yaw when pivoting on the other wheel
+        heading += (velocities[0] - velocities[1]) * interval;
+        float speed = (velocities[0] + velocities[1]) / 2 * DEG_TO_RAD * TrackWidth;
+        x += speed * cos(heading * DEG_TO_RAD) * interval;
+        y += speed * sin(heading * DEG_TO_RAD) * interval;
+        // Drives should stay on their line, turns should stay in place
+        deviation = max(deviation, scenario->move > 1 ? abs(y) : sqrtf(x * x + y * y));
+    }
+}
+
+/// @brief Converts a servo command to a pulse width.
+/// @param command The servo command, in degrees or in microseconds if 500 or more.
+/// @return The pulse width in microseconds.
+float Simulator::toPulse(int command)
+{
+    return command >= 500 ? command : 500 + command * 2000.0f / 180;
+}
+
+/// @brief Models a continuous rotation servo's velocity.
+/// @param pulse The pulse width in microseconds.
+/// @param zero The pulse width the servo is stopped at.
+/// @return The velocity, positive above the stopped point.
+float Simulator::wheelVelocity(float pulse, float zero)
+{
+    float offset = pulse - zero;
+    if (abs(offset) <= scenario->deadband)
+    {
+        return 0;
+    }
+    offset -= offset > 0 ? scenario->deadband : -scenario->deadband;
+    return MaxVelocity * tanh(offset / PulseScale);
+}
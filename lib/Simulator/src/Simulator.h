@@ -0,0 +1,165 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Replays moves through the robot's real motion code against a model of the wheels and gyro instead of the hardware,
+ * so a control change can be checked for heading error, path deviation, completion time and servo jitter
+ * without the robot leaving the bench. The gyro noise can be synthetic or taken from the last recorded move.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <Configuration.h>
+#include <FlightRecorder.h>
+#include <Logger.h>
+
+class RuckusBot;
+
+/// @brief Differential drive plant model and the replay scenarios run against it.
+class Simulator
+{
+    public:
+        Simulator(Configuration* Config, FlightRecorder* Recorder);
+        bool run(RuckusBot* bot, String scenarios);
+        String getResults();
+        bool passed();
+        void command(int leftCommand, int rightCommand);
+        float readGyro();
+
+        /// @brief Most scenarios run at once.
+        static const int MaxScenarios = 8;
+
+    private:
+        /// @brief A move and the plant it's run against, with its pass limits.
+        struct Scenario
+        {
+            /// @brief The scenario name.
+            String name;
+            /// @brief The move, numbered as CommandProcessor::Movements.
+            int move;
+            /// @brief The move magnitude.
+            int magnitude;
+            /// @brief How much faster the left wheel is than the right, as a fraction.
+            float mismatch;
+            /// @brief Error in each wheel's stopped point in microseconds.
+            float zeroError;
+            /// @brief Half width of each wheel's deadband in microseconds.
+            float deadband;
+            /// @brief Wheel response time constant in milliseconds.
+            float lag;
+            /// @brief Gyro bias in degrees per second.
+            float gyroBias;
+            /// @brief Peak synthetic gyro noise in degrees per second.
+            float gyroNoise;
+            /// @brief Use the vibration from the last recorded move instead of synthetic noise.
+            bool recordedNoise;
+            /// @brief Largest allowed final heading error in degrees.
+            float maxHeadingError;
+            /// @brief Largest allowed distance from the ideal path in millimeters.
+            float maxDeviation;
+            /// @brief Largest allowed average change between servo commands in microseconds.
+            float maxJitter;
+            /// @brief Longest allowed move in milliseconds.
+            uint32_t maxTime;
+        };
+
+        /// @brief Measurements from one scenario.
+        struct Result
+        {
+            /// @brief Final heading minus the intended heading in degrees.
+            float headingError;
+            /// @brief Largest distance from the ideal path in millimeters.
+            float deviation;
+            /// @brief Time the move took in milliseconds.
+            uint32_t time;
+            /// @brief Average change between successive servo commands in microseconds.
+            float jitter;
+            /// @brief Number of servo commands written.
+            int commands;
+            /// @brief True if every measurement was within its limit.
+            bool passed;
+        };
+
+        /// @brief Distance between the wheels in millimeters.
+        static constexpr float TrackWidth = 90;
+
+        /// @brief Wheel velocity at full command, in degrees per second of yaw if the wheel pivoted the robot alone.
+        static constexpr float MaxVelocity = 120;
+
+        /// @brief Pulse width offset at which a wheel reaches about three quarters of full velocity.
+        static constexpr float PulseScale = 400;
+
+        /// @brief Plant integration step in microseconds.
+        static const int Step = 2000;
+
+        /// @brief Time the robot is left to coast after a move before the final heading is taken, in microseconds.
+        static const int SettleTime = 500000;
+
+        /// @brief Number of recorded gyro samples kept for replaying as noise.
+        static const int NoiseSamples = 256;
+
+        /// @brief A reference to the shared configuration object.
+        Configuration* config;
+
+        /// @brief A reference to the flight recorder holding recorded moves.
+        FlightRecorder* recorder;
+
+        /// @brief Scenarios of the last run.
+        Scenario scenarios[MaxScenarios];
+
+        /// @brief Results of the last run.
+        Result results[MaxScenarios];
+
+        /// @brief Number of scenarios in the last run.
+        int count = 0;
+
+        /// @brief True once a run has finished.
+        bool complete = false;
+
+        /// @brief The scenario being run.
+        Scenario* scenario = NULL;
+
+        /// @brief Last plant update in microseconds since boot.
+        int64_t updated;
+
+        /// @brief Current left and right wheel pulse widths in microseconds.
+        float pulses[2];
+
+        /// @brief Current left and right forward wheel velocities.
+        float velocities[2];
+
+        /// @brief Heading in degrees, positive clockwise.
+        float heading;
+
+        /// @brief Position in millimeters, x along the starting heading.
+        float x;
+        float y;
+
+        /// @brief Largest distance from the ideal path so far.
+        float deviation;
+
+        /// @brief Sum of the changes between successive servo commands, and the last change.
+        float jitterSum;
+        float lastJitter;
+
+        /// @brief Number of servo commands written.
+        int commands;
+
+        /// @brief High-pass filtered gyro rates from the last recorded move.
+        float noise[NoiseSamples];
+
+        /// @brief Number of recorded noise samples, and the next one to use.
+        int noiseCount = 0;
+        int noiseIndex = 0;
+
+        bool parse(String json);
+        void addScenario(const char* name, int move, int magnitude, float mismatch, float zeroError, float lag, float gyroNoise, bool recordedNoise);
+        Result runScenario(RuckusBot* bot, Scenario& current);
+        void loadNoise();
+        void advance(int64_t time);
+        float toPulse(int command);
+        float wheelVelocity(float pulse, float zero);
+};
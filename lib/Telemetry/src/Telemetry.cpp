@@ -0,0 +1,124 @@
+#include "Telemetry.h"
+
+/// @brief Creates a telemetry publisher.
+/// @param Recorder A reference to the flight recorder that keeps every sample.
+Telemetry::Telemetry(FlightRecorder* Recorder) : socket("/telemetry")
+{
+    recorder = Recorder;
+    state = Frame { 0, 0, 0, 0, 0, 0, Idle, 0, 0, 0 };
+}
+
+/// @brief Starts the task sending frames to subscribers.
+void Telemetry::begin()
+{
+    xTaskCreate(Telemetry::TelemetryTaskWrapper, "Telemetry", 3072, this, 1, NULL);
+}
+
+/// @brief Gets the WebSocket handler to register with the web server.
+/// @return The WebSocket handler.
+AsyncWebSocket* Telemetry::getSocket()
+{
+    return &socket;
+}
+
+/// @brief Sets how often frames are sampled and published.
+/// The state only changes as often as the control loops update it, faster rates repeat values.
+/// @param rate The rate in Hz, from 1 to 100.
+/// @return True on success.
+bool Telemetry::setRate(int rate)
+{
+    if (rate < 1 || rate > 100)
+    {
+        return false;
+    }
+    period = 1000 / rate;
+    return true;
+}
+
+/// @brief Gets how often frames are published.
+/// @return The rate in Hz.
+int Telemetry::getRate()
+{
+    return 1000 / period;
+}
+
+/// @brief Records the state of the control loop. Call only from the command processor task.
+/// @param heading The integrated heading in degrees.
+/// @param gyroRate The raw gyro rate in degrees per second.
+/// @param leftServo The command sent to the left servo.
+/// @param rightServo The command sent to the right servo.
+void Telemetry::updateMotion(float heading, float gyroRate, int leftServo, int rightServo)
+{
+    portENTER_CRITICAL(&stateLock);
+    state.heading = heading;
+    state.gyroRate = gyroRate;
+    state.leftServo = leftServo;
+    state.rightServo = rightServo;
+    portEXIT_CRITICAL(&stateLock);
+    recorder->record(gyroRate, heading, leftServo, rightServo);
+}
+
+/// @brief Records the command being processed. Call only from the command processor task.
+/// @param commandType The type of the current command, or Idle.
+/// @param command The current command.
+/// @param queueDepth The number of commands waiting in the queue.
+void Telemetry::updateCommand(int commandType, int command, int queueDepth)
+{
+    portENTER_CRITICAL(&stateLock);
+    state.commandType = commandType;
+    state.command = command;
+    state.queueDepth = queueDepth;
+    portEXIT_CRITICAL(&stateLock);
+    if (commandType != Idle)
+    {
+        recorder->beginCommand(commandType, command);
+    }
+}
+
+/// @brief Records the battery voltage. Safe to call from any task.
+/// @param voltage The battery voltage in volts.
+void Telemetry::updateBattery(float voltage)
+{
+    batteryVoltage = voltage * 1000;
+}
+
+/// @brief Wraps the telemetry task for static access.
+/// @param arg The Telemetry object.
+void Telemetry::TelemetryTaskWrapper(void* arg)
+{
+    static_cast<Telemetry*>(arg)->TelemetryTask();
+}
+
+/// @brief Runs in an infinite loop sampling the state at the set rate and sending it to subscribers.
+void Telemetry::TelemetryTask()
+{
+    Frame frame;
+    uint32_t lastCleanup = 0;
+    TickType_t wake = xTaskGetTickCount();
+    while (true)
+    {
+        if (socket.count() > 0)
+        {
+            portENTER_CRITICAL(&stateLock);
+            frame = state;
+            portEXIT_CRITICAL(&stateLock);
+            frame.timestamp = millis();
+            frame.batteryVoltage = batteryVoltage;
+            // Drop frames rather than wait on slow subscribers
+            if (socket.availableForWriteAll())
+            {
+                socket.binaryAll((uint8_t*)&frame, sizeof(Frame));
+            }
+            else
+            {
+                DroppedFrames++;
+            }
+        }
+        if (millis() - lastCleanup > 1000)
+        {
+            socket.cleanupClients();
+            lastCleanup = millis();
+        }
+        vTaskDelayUntil(&wake, period / portTICK_PERIOD_MS);
+    }
+}
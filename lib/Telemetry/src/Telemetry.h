@@ -0,0 +1,79 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Streams the state of the control loop over a WebSocket at /telemetry.
+ * Each binary WebSocket message holds one or more 22-byte frames, all fields little-endian:
+ * uint32 timestamp (ms), float heading (degrees), float gyro rate (degrees/s),
+ * int16 left servo command, int16 right servo command, uint8 command queue depth,
+ * uint8 current command type (255 when idle), uint8 current command, uint8 reserved,
+ * uint16 battery voltage (mV, 0 if not measured).
+ *
+ * External libraries needed:
+ * ESPAsyncWebServer: https://github.com/esphome/ESPAsyncWebServer
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <FlightRecorder.h>
+
+/// @brief Publishes control loop telemetry without ever blocking the motion task.
+/// The motion task only updates the latest state, frames are sampled from it at the set rate by the telemetry task.
+class Telemetry
+{
+    public:
+        /// @brief Command type reported when no command is running.
+        static const uint8_t Idle = 255;
+
+        /// @brief A single telemetry sample.
+        struct __attribute__((packed)) Frame
+        {
+            uint32_t timestamp;
+            float heading;
+            float gyroRate;
+            /// @brief Servo commands, in degrees or in microseconds if 500 or more
+            int16_t leftServo;
+            int16_t rightServo;
+            uint8_t queueDepth;
+            uint8_t commandType;
+            uint8_t command;
+            uint8_t reserved;
+            uint16_t batteryVoltage;
+        };
+
+        /// @brief Frames dropped because no subscriber could take them.
+        uint32_t DroppedFrames = 0;
+
+        Telemetry(FlightRecorder* Recorder);
+        void begin();
+        AsyncWebSocket* getSocket();
+        bool setRate(int rate);
+        int getRate();
+        void updateMotion(float heading, float gyroRate, int leftServo, int rightServo);
+        void updateCommand(int commandType, int command, int queueDepth);
+        void updateBattery(float voltage);
+        static void TelemetryTaskWrapper(void* arg);
+
+    private:
+        /// @brief A reference to the flight recorder that keeps every sample.
+        FlightRecorder* recorder;
+
+        /// @brief The WebSocket subscribers connect to.
+        AsyncWebSocket socket;
+
+        /// @brief The most recent state, only written by the motion task.
+        Frame state;
+
+        /// @brief Guards state while it's written or sampled.
+        portMUX_TYPE stateLock = portMUX_INITIALIZER_UNLOCKED;
+
+        /// @brief Latest battery voltage in millivolts, written by the battery monitor.
+        volatile uint16_t batteryVoltage = 0;
+
+        /// @brief Time between frames in milliseconds.
+        volatile uint32_t period = 20;
+
+        void TelemetryTask();
+};
@@ -0,0 +1,97 @@
+#include "WarmRestart.h"
+
+// Not initialized at boot, so it keeps its value through software, watchdog, panic and brownout resets
+RTC_NOINIT_ATTR WarmRestart::State WarmRestart::state;
+bool WarmRestart::warm = false;
+portMUX_TYPE WarmRestart::lock = portMUX_INITIALIZER_UNLOCKED;
+
+/// @brief Checks the state kept from before the reset, starting fresh if it can't be trusted. Call once at the start of setup.
+/// @return True if the robot was assigned to a player before the reset and can rejoin with the same assignment.
+bool WarmRestart::begin()
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    // After a power-on the RTC memory holds whatever it powered up with
+    bool valid = reason != ESP_RST_POWERON && reason != ESP_RST_UNKNOWN && state.token == Token && state.crc == stateCRC();
+    if (!valid)
+    {
+        state = State { Token, 0, 0, 0, 0, 0 };
+        seal();
+        Logger::info("Cold start, reset reason %d", reason);
+        return false;
+    }
+    state.restarts++;
+    seal();
+    warm = state.player > 0;
+    Logger::info("Warm restart %u, reset reason %d, player %d, robot %d", state.restarts, reason, state.player, state.robotNumber);
+    return warm;
+}
+
+/// @brief Checks if the robot restarted while assigned to a player.
+/// @return True if the assignment was restored.
+bool WarmRestart::isWarm()
+{
+    return warm;
+}
+
+/// @brief Gets the player assigned before the reset.
+/// @return The player number, 0 if none.
+int WarmRestart::getPlayer()
+{
+    return state.player;
+}
+
+/// @brief Gets the robot number assigned before the reset.
+/// @return The robot number.
+int WarmRestart::getRobotNumber()
+{
+    return state.robotNumber;
+}
+
+/// @brief Gets the image displayed before the reset.
+/// @return The image, as a RuckusBot::images value.
+int WarmRestart::getImage()
+{
+    return state.image;
+}
+
+/// @brief Gets the number of warm restarts since the robot was powered on.
+/// @return The number of restarts.
+uint32_t WarmRestart::getRestarts()
+{
+    return state.restarts;
+}
+
+/// @brief Keeps the game assignment.
+/// @param player The player number, 0 when the game is reset.
+/// @param robotNumber The robot number.
+void WarmRestart::setAssignment(int player, int robotNumber)
+{
+    portENTER_CRITICAL(&lock);
+    state.player = player;
+    state.robotNumber = robotNumber;
+    seal();
+    portEXIT_CRITICAL(&lock);
+}
+
+/// @brief Keeps the displayed image.
+/// @param image The image, as a RuckusBot::images value.
+void WarmRestart::setImage(int image)
+{
+    portENTER_CRITICAL(&lock);
+    state.image = image;
+    seal();
+    portEXIT_CRITICAL(&lock);
+}
+
+/// @brief Updates the CRC after a change.
+void WarmRestart::seal()
+{
+    state.crc = stateCRC();
+}
+
+/// @brief Calculates the CRC of the state.
+/// @return The CRC32 of everything after the CRC field.
+uint32_t WarmRestart::stateCRC()
+{
+    return crc32_le(0, (const uint8_t*)&state + 2 * sizeof(uint32_t), sizeof(State) - 2 * sizeof(uint32_t));
+}
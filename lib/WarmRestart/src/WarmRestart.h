@@ -0,0 +1,52 @@
+/*
+ * This file and associated .cpp file are licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Keeps the robot's game assignment and display in RTC memory, which survives resets but not power loss,
+ * so a robot that reboots mid-game can rejoin with the same assignment instead of being set up again.
+ * The state is only trusted if its token and CRC are intact and the reset wasn't a power-on.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <esp_system.h>
+#include <esp32/rom/crc.h>
+#include <Logger.h>
+
+class WarmRestart
+{
+    public:
+        static bool begin();
+        static bool isWarm();
+        static int getPlayer();
+        static int getRobotNumber();
+        static int getImage();
+        static uint32_t getRestarts();
+        static void setAssignment(int player, int robotNumber);
+        static void setImage(int image);
+
+    private:
+        /// @brief Marks valid state, includes the layout size so a firmware with a different layout ignores it.
+        static const uint32_t Token = 0x57524D00 | sizeof(int32_t) * 5;
+
+        /// @brief Game state kept across resets.
+        struct State
+        {
+            uint32_t token;
+            /// @brief CRC32 of everything after this field
+            uint32_t crc;
+            int32_t player;
+            int32_t robotNumber;
+            int32_t image;
+            /// @brief Number of warm restarts since power-on
+            uint32_t restarts;
+        };
+
+        static State state;
+        static bool warm;
+        static portMUX_TYPE lock;
+
+        static void seal();
+        static uint32_t stateCRC();
+};
@@ -0,0 +1,97 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Generated by lib/Webserver/web/build_page.py from lib/Webserver/web/index.html, do not edit.
+ * Uncompressed size: 3048 bytes
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/// @brief ETag identifying this version of the page
+const char indexPageETag[] = "\"d16a87314a209f13\"";
+
+/// @brief Length of the compressed page in bytes
+const size_t indexPageLength = 1241;
+
+/// @brief Gzip compressed firmware update page, stored in flash
+const uint8_t indexPage[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x56, 0xdf, 0x6f, 0xdb, 0x36,
+    0x10, 0x7e, 0xf7, 0x5f, 0xc1, 0xc2, 0x28, 0x24, 0x6f, 0x96, 0xac, 0xa4, 0xcd, 0x92, 0x49, 0xb6,
+    0x1f, 0xda, 0x24, 0xe8, 0xb0, 0x66, 0x09, 0xd2, 0x14, 0xd8, 0x30, 0xec, 0x81, 0x96, 0x28, 0x9b,
+    0x2b, 0x4d, 0x6a, 0x24, 0x15, 0xdb, 0x4b, 0xfd, 0xbf, 0xef, 0x48, 0x91, 0xb6, 0x64, 0x27, 0x79,
+    0x98, 0x03, 0x47, 0xe6, 0xf1, 0x7e, 0x7c, 0xf7, 0xdd, 0x1d, 0xa9, 0xf1, 0x9b, 0xcb, 0xdb, 0x8f,
+    0x0f, 0x7f, 0xdc, 0x5d, 0xa1, 0x85, 0x5e, 0xb2, 0x69, 0x6f, 0x6c, 0x1e, 0x88, 0x61, 0x3e, 0x9f,
+    0x04, 0x84, 0x47, 0xb5, 0x0a, 0x8c, 0x8c, 0xe0, 0x02, 0x1e, 0x9a, 0x6a, 0x46, 0xa6, 0xd7, 0x54,
+    0x2e, 0x57, 0x58, 0x12, 0xf4, 0xb5, 0x2a, 0xb0, 0x26, 0x72, 0x3c, 0x6a, 0xe4, 0xbd, 0xf1, 0xc8,
+    0xe9, 0xcd, 0x44, 0xb1, 0x81, 0x47, 0x41, 0x1f, 0x11, 0x2d, 0x26, 0x41, 0x5d, 0x45, 0x2b, 0x89,
+    0x2b, 0xeb, 0xe8, 0xc4, 0x4a, 0x16, 0xf5, 0xec, 0x37, 0xbc, 0x24, 0xc1, 0x14, 0x4c, 0x4e, 0x8c,
+    0xf8, 0x74, 0xfa, 0xb5, 0x62, 0x02, 0x17, 0xc8, 0x3b, 0x87, 0x8d, 0xd3, 0xae, 0x8b, 0x4a, 0x8a,
+    0xb9, 0x24, 0xca, 0xe0, 0x41, 0xf0, 0x69, 0x6f, 0xcd, 0xb0, 0x34, 0xae, 0x40, 0x72, 0xbc, 0x57,
+    0x11, 0x99, 0x13, 0xae, 0x83, 0x69, 0xf2, 0xd6, 0x69, 0xf8, 0x07, 0xe5, 0x55, 0xad, 0x91, 0xde,
+    0x54, 0x64, 0x12, 0x94, 0x94, 0x91, 0xc0, 0x9b, 0x34, 0x8b, 0x82, 0x2a, 0x3c, 0x63, 0xa4, 0x40,
+    0x23, 0xd0, 0x65, 0x78, 0x46, 0x18, 0x2a, 0x85, 0x6c, 0x29, 0x38, 0x6d, 0xbb, 0xe5, 0x40, 0x35,
+    0x8c, 0x40, 0x04, 0x2b, 0x6c, 0xe1, 0x5f, 0x02, 0x70, 0x3c, 0x27, 0x3b, 0x94, 0xfe, 0xa1, 0x72,
+    0x49, 0x2b, 0x3d, 0xed, 0x15, 0x22, 0xaf, 0x97, 0x00, 0x33, 0xc6, 0x45, 0x71, 0xf5, 0x08, 0x3f,
+    0x3e, 0x53, 0xa5, 0x09, 0x27, 0x32, 0x0c, 0x2e, 0x6f, 0x6f, 0x3e, 0x0a, 0xae, 0x8d, 0x0c, 0x08,
+    0x22, 0x45, 0x30, 0x44, 0x21, 0x19, 0xa0, 0xc9, 0x14, 0x3d, 0xf5, 0x4a, 0xa2, 0xf3, 0x45, 0x18,
+    0x8c, 0xb8, 0x21, 0x73, 0x10, 0xeb, 0x05, 0xe1, 0x61, 0x08, 0x24, 0x55, 0x82, 0xab, 0x46, 0xc7,
+    0x2f, 0x62, 0x4d, 0xd6, 0x3a, 0x1c, 0x78, 0x1d, 0x63, 0xd0, 0xf8, 0x40, 0xbb, 0xd0, 0x73, 0xa2,
+    0xaf, 0x18, 0x31, 0x3f, 0x3f, 0x6c, 0x7e, 0x29, 0xc2, 0x5d, 0x91, 0x06, 0xd6, 0xd6, 0x61, 0x40,
+    0x13, 0x64, 0x6c, 0x33, 0xb4, 0x1d, 0x64, 0x3d, 0xf3, 0x7d, 0xc4, 0x12, 0xd5, 0xa6, 0x36, 0xb0,
+    0xf3, 0x64, 0x49, 0x58, 0x7c, 0x00, 0x51, 0x8a, 0x78, 0xcd, 0xd8, 0xb0, 0x11, 0xdc, 0x35, 0x35,
+    0xe8, 0x0a, 0xaf, 0x81, 0xc4, 0x8e, 0x84, 0x72, 0x6a, 0x54, 0x42, 0x97, 0x1b, 0x72, 0x1f, 0xeb,
+    0x3c, 0xb6, 0x4e, 0x27, 0x2f, 0x83, 0x75, 0x5d, 0x00, 0x80, 0x0e, 0xec, 0x7c, 0xec, 0xd7, 0x6d,
+    0x7d, 0x97, 0x1c, 0xdb, 0x5b, 0x98, 0xaf, 0x1b, 0xdb, 0x76, 0x78, 0xde, 0x32, 0xde, 0x75, 0xd1,
+    0x04, 0x95, 0x98, 0x29, 0xb2, 0xd7, 0x7a, 0xcd, 0x63, 0xd3, 0x53, 0x83, 0x58, 0xf0, 0x9c, 0xd1,
+    0xfc, 0x1b, 0x18, 0x37, 0x3e, 0x6b, 0x3b, 0x24, 0x8d, 0x8f, 0x6d, 0xc3, 0x5a, 0x6d, 0x5b, 0xce,
+    0xf0, 0xe6, 0x72, 0x68, 0xd1, 0x57, 0xed, 0x72, 0xf7, 0xbf, 0x7e, 0x44, 0xc1, 0xdb, 0x20, 0xeb,
+    0x75, 0x79, 0x8d, 0x95, 0xde, 0x00, 0xd4, 0x15, 0x2d, 0xf4, 0x62, 0xaf, 0xdb, 0xd1, 0x72, 0x2c,
+    0xc6, 0x94, 0x43, 0x4f, 0x7e, 0x7a, 0xb8, 0xf9, 0x7c, 0xa8, 0x47, 0xcb, 0x1d, 0x00, 0x34, 0x99,
+    0xa0, 0xe0, 0x24, 0x49, 0xde, 0x06, 0x03, 0x68, 0xaf, 0x57, 0xc9, 0x40, 0xdb, 0x6e, 0x2a, 0xf6,
+    0x08, 0xe8, 0xb6, 0x00, 0x2d, 0xc3, 0xb6, 0x0b, 0xc3, 0xb5, 0x8a, 0x19, 0xe1, 0x73, 0x83, 0x75,
+    0x82, 0x12, 0x34, 0x68, 0xf4, 0x24, 0xd1, 0xb5, 0xe4, 0x8e, 0x1a, 0xfb, 0x9f, 0x11, 0x8d, 0xca,
+    0xa6, 0x7a, 0x47, 0x1e, 0xfe, 0x4c, 0xfe, 0xea, 0xe4, 0x77, 0x08, 0x4f, 0xcb, 0x9a, 0x1c, 0x2b,
+    0x3c, 0x62, 0x56, 0x1b, 0x77, 0x81, 0xa3, 0xd0, 0x44, 0x58, 0x2f, 0x4c, 0x5f, 0x72, 0xb2, 0x42,
+    0xbf, 0xdf, 0x7c, 0xfe, 0xa4, 0x75, 0x75, 0x4f, 0xfe, 0xa9, 0x89, 0x82, 0x59, 0x1b, 0x22, 0xa8,
+    0x0c, 0x76, 0x9b, 0xd7, 0x42, 0x2e, 0x2f, 0x61, 0x19, 0xba, 0x3e, 0x31, 0x5b, 0x31, 0xae, 0x2a,
+    0xc2, 0x6d, 0xc5, 0x6d, 0x0b, 0x0d, 0x2d, 0x5c, 0xa7, 0x00, 0x7e, 0x63, 0x01, 0xdb, 0x61, 0x70,
+    0x77, 0xfb, 0xe5, 0x01, 0xf6, 0x82, 0x51, 0x53, 0x6a, 0xdf, 0x69, 0x26, 0xf8, 0xbe, 0xc0, 0xc9,
+    0x10, 0xf9, 0xfa, 0x25, 0x7b, 0x07, 0x0d, 0xa3, 0xd0, 0x46, 0xe6, 0xa1, 0x34, 0x96, 0x46, 0x35,
+    0x24, 0x8f, 0xae, 0x49, 0x76, 0x5d, 0x65, 0xfc, 0x86, 0xc9, 0x00, 0xea, 0xf1, 0x82, 0x2d, 0xc0,
+    0x7c, 0xc5, 0x12, 0x8a, 0xfd, 0x82, 0xad, 0x3f, 0xb4, 0x3b, 0xc6, 0xbb, 0x11, 0xd8, 0xc3, 0xbf,
+    0xc1, 0x7a, 0x11, 0xe7, 0x84, 0xb2, 0xd0, 0xa8, 0xc5, 0x36, 0x24, 0x9c, 0xbc, 0xc8, 0x2c, 0xb4,
+    0xd0, 0x98, 0x0d, 0xd0, 0x0f, 0xc8, 0x86, 0x39, 0x98, 0x32, 0x87, 0xc0, 0xf7, 0xbe, 0xab, 0x7f,
+    0x8b, 0x42, 0x0b, 0xdf, 0x34, 0x5c, 0xcd, 0x73, 0x4d, 0x05, 0x37, 0xcd, 0xb5, 0x47, 0x60, 0xda,
+    0x56, 0x2f, 0xa8, 0x8a, 0xfd, 0x39, 0x89, 0xde, 0x40, 0x79, 0x6f, 0x7f, 0x0d, 0xd0, 0xf7, 0xef,
+    0xc8, 0x6e, 0x00, 0x6b, 0xba, 0x56, 0x46, 0x7c, 0x0a, 0xe1, 0x5b, 0xa6, 0x2f, 0xce, 0xaf, 0x3f,
+    0xeb, 0x07, 0x9d, 0x69, 0x09, 0xae, 0xee, 0xef, 0x6f, 0xef, 0xdf, 0x04, 0xfb, 0x04, 0xb6, 0x88,
+    0xc0, 0x0c, 0x1c, 0x9d, 0x74, 0x6d, 0x4e, 0xff, 0x77, 0xb0, 0x2f, 0x75, 0x9e, 0xc3, 0xce, 0x10,
+    0xc6, 0x62, 0x26, 0x84, 0xa6, 0x7c, 0xde, 0x89, 0x7c, 0xc8, 0x92, 0x32, 0x6d, 0x68, 0x5a, 0xd2,
+    0x13, 0xd8, 0x83, 0xcd, 0x15, 0xe5, 0x85, 0x58, 0x3d, 0x73, 0x23, 0x19, 0x46, 0xa1, 0x21, 0x1b,
+    0xb8, 0xe6, 0xd4, 0x06, 0xab, 0xf1, 0xc8, 0x5f, 0x65, 0x63, 0x7b, 0x9a, 0x4c, 0x7b, 0x7d, 0x07,
+    0xed, 0xa9, 0x84, 0x9b, 0x23, 0x52, 0xf4, 0x5f, 0x92, 0x9e, 0x5c, 0x54, 0xeb, 0xcc, 0x2e, 0x57,
+    0x84, 0xce, 0x17, 0x3a, 0x9d, 0x09, 0x56, 0x10, 0xb9, 0xed, 0xf5, 0xdd, 0x29, 0x3a, 0xec, 0xfb,
+    0xc3, 0xef, 0xc9, 0x76, 0x73, 0x6a, 0x8e, 0x91, 0x6c, 0xd1, 0x28, 0xbf, 0x7f, 0x0f, 0xd6, 0x33,
+    0x21, 0xc1, 0x22, 0x92, 0xb8, 0xa0, 0xb5, 0x4a, 0x8d, 0x64, 0x89, 0xe5, 0x9c, 0x72, 0xd0, 0xac,
+    0xd6, 0x08, 0xd7, 0x5a, 0x64, 0xad, 0x78, 0xe7, 0xd5, 0xba, 0x71, 0xde, 0xf8, 0x9c, 0xe1, 0xfc,
+    0xdb, 0x5c, 0x8a, 0x9a, 0x17, 0x69, 0xbf, 0x3c, 0x31, 0x7f, 0xce, 0x5f, 0x9a, 0x64, 0x30, 0xfc,
+    0x15, 0xc3, 0x9b, 0x74, 0xc6, 0x44, 0xfe, 0x2d, 0x63, 0x94, 0x93, 0xa8, 0x15, 0x77, 0xdb, 0x33,
+    0xef, 0x34, 0x1d, 0x07, 0xef, 0xde, 0xff, 0x7c, 0x51, 0xcc, 0x9a, 0x68, 0x25, 0x5e, 0x52, 0xb6,
+    0x49, 0x15, 0xe6, 0x2a, 0x52, 0x44, 0xd2, 0xb2, 0x0d, 0xc2, 0x80, 0xcc, 0x05, 0x13, 0x32, 0xed,
+    0x9f, 0x9f, 0x9f, 0xef, 0x93, 0x7d, 0xaa, 0x80, 0x5a, 0xa8, 0x0c, 0x04, 0x77, 0x28, 0x4e, 0x20,
+    0x05, 0x25, 0x18, 0x2d, 0x50, 0xbf, 0x28, 0x8a, 0x23, 0x10, 0x99, 0xb9, 0x87, 0x23, 0xcc, 0xe8,
+    0x9c, 0xa7, 0x8c, 0x94, 0xfa, 0x00, 0x73, 0x5e, 0x4b, 0x05, 0x41, 0x2a, 0x41, 0xe1, 0xa6, 0x76,
+    0xa4, 0xc2, 0x9d, 0x68, 0x39, 0xf5, 0x73, 0xd8, 0xca, 0x20, 0x72, 0x98, 0x3a, 0x44, 0x78, 0x62,
+    0x0d, 0x9b, 0x59, 0x25, 0x14, 0x35, 0x23, 0x93, 0x4a, 0xc2, 0xb0, 0xa6, 0x8f, 0x64, 0xe7, 0xf3,
+    0x19, 0x37, 0x8e, 0x8e, 0xa6, 0x6c, 0xfb, 0xa2, 0xbd, 0x4b, 0x7c, 0x09, 0xcc, 0x2b, 0x60, 0xb7,
+    0x02, 0x65, 0x09, 0xc5, 0x5b, 0x47, 0x8d, 0xc9, 0xe9, 0xd9, 0xc5, 0xbe, 0x98, 0xe7, 0x67, 0xbe,
+    0x98, 0x9e, 0x23, 0xe3, 0xe7, 0x00, 0xe3, 0x59, 0x97, 0x11, 0x33, 0xff, 0x3e, 0xed, 0xe3, 0x72,
+    0x3b, 0x78, 0x3e, 0x67, 0x08, 0xfd, 0x1c, 0x5d, 0xee, 0x18, 0x79, 0xda, 0x65, 0x8e, 0x67, 0x50,
+    0x8f, 0x5a, 0x93, 0x4c, 0x8b, 0x2a, 0xfd, 0x09, 0x02, 0x1a, 0xde, 0xa1, 0x60, 0xad, 0xee, 0xf4,
+    0x45, 0x28, 0x19, 0x59, 0x67, 0x16, 0x4a, 0x44, 0x35, 0x59, 0x2a, 0x07, 0x28, 0xfb, 0xbb, 0x56,
+    0x9a, 0x96, 0x1b, 0xe0, 0xc9, 0xbe, 0x40, 0x79, 0xb1, 0x45, 0xae, 0x16, 0x18, 0x46, 0x2c, 0x8d,
+    0x4c, 0xe1, 0xcd, 0x37, 0x41, 0xfd, 0x24, 0x49, 0x86, 0xcf, 0x2c, 0xa3, 0xd6, 0x3a, 0x3a, 0x10,
+    0xb4, 0xb2, 0xda, 0xc2, 0x1c, 0x36, 0xe3, 0x37, 0x1e, 0xb9, 0xb7, 0xf0, 0x51, 0xf3, 0x5e, 0xff,
+    0x1f, 0xab, 0x88, 0x59, 0xee, 0xe8, 0x0b, 0x00, 0x00,
+};
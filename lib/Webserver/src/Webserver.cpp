@@ -1,14 +1,23 @@
 #include "Webserver.h"
+#include "IndexPage.h"
 
 /// @brief Creates a webserver object.
 /// @param config A configuration object reference.
 /// @param Command A CommandProcessor object reference.
 /// @param webserver An AsyncWebServer object reference.
-Webserver::Webserver(Configuration* Config, CommandProcessor* Command, AsyncWebServer* webserver)
+/// @param Telem A Telemetry object reference.
+/// @param Communication An HTTPCommunication object reference.
+/// @param Recorder A FlightRecorder object reference.
+/// @param Health A HealthMonitor object reference.
+Webserver::Webserver(Configuration* Config, CommandProcessor* Command, AsyncWebServer* webserver, Telemetry* Telem, HTTPCommunication* Communication, FlightRecorder* Recorder, HealthMonitor* Health)
 {
     server = webserver;
     config = Config;
     command = Command;
+    telemetry = Telem;
+    communication = Communication;
+    recorder = Recorder;
+    health = Health;
 }
 
 /// @brief Starts the update server
@@ -16,26 +25,68 @@ void Webserver::ServerStart()
 {
     Serial.println("Starting update server");
     // Add requests
-    server->on("/", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        request->send(HTTP_CODE_OK, "text/html", this->indexPage_Part1 + config->BotConfig.RobotName + this->indexPage_Part2);
+    server->on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+        // The page only changes with the firmware, so browsers can revalidate their cached copy
+        AsyncWebHeader* cached = request->getHeader("If-None-Match");
+        if (cached != NULL && cached->value() == indexPageETag)
+        {
+            request->send(HTTP_CODE_NOT_MODIFIED);
+            return;
+        }
+        // Streamed from flash in chunks, already compressed
+        AsyncWebServerResponse *response = request->beginResponse_P(HTTP_CODE_OK, "text/html", indexPage, indexPageLength);
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("ETag", indexPageETag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+    });
+
+    // Returns the robot name
+    server->on("/name", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "text/plain", this->config->BotConfig.RobotName);
     });
 
     // Upload a file
     server->on("/update", HTTP_POST, [this](AsyncWebServerRequest *request) {
-            shouldReboot = !Update.hasError();
-            AsyncWebServerResponse *response = request->beginResponse(HTTP_CODE_OK, "text/plain", this->shouldReboot ? "OK" : "FAIL");
+            if (!this->updater.startedBy(request))
+            {
+                request->send(HTTP_CODE_CONFLICT, "text/plain", "Update already in progress");
+                return;
+            }
+            // The writer task finishes the update after the upload, so the result is sent once it's done
+            AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain", [this](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                if (this->updater.inProgress())
+                {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                if (index > 0)
+                {
+                    return 0;
+                }
+                this->shouldReboot = !this->updater.hasError();
+                return snprintf((char*)buffer, maxLen, "%s", this->shouldReboot ? "OK" : "FAIL");
+            });
             response->addHeader("Connection", "close");
             request->send(response); 
-        }, onUpdate);
+        }, [this](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+            this->onUpdate(request, filename, index, data, len, final);
+        });
+
+    // Returns the results of the last firmware update
+    server->on("/updateStatus", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->updater.getStatistics());
+    });
 
     // Receives a move command
     server->on("/move", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        if(request->hasParam("move", true) && request->hasParam("magnitude", true))
+        PROFILE_SCOPE("Move request");
+        int move, magnitude;
+        // Optional game server time in milliseconds to start the move at
+        double executeAt = 0;
+        FormParameter parameters[] = { { "move", &move }, { "magnitude", &magnitude }, { "executeAt", NULL, &executeAt, true } };
+        if(readParameters(request, parameters, 3))
         {
-            int move = request->getParam("move", true)->value().toInt();
-            int magnitude = request->getParam("magnitude", true)->value().toInt();
-            this->command->AddCommandToQueue(CommandProcessor::CommandTypes::Movement, (CommandProcessor::Movements)move, magnitude);
-            request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+            sendQueued(request, this->command->AddCommandToQueue(CommandProcessor::CommandTypes::Movement, (CommandProcessor::Movements)move, magnitude, executeAt));
         }
         else 
         {
@@ -45,11 +96,11 @@ void Webserver::ServerStart()
 
     // Receives a player assignment
     server->on("/assignPlayer", HTTP_PUT, [this](AsyncWebServerRequest *request) {
-        if(request->hasParam("player", true) && request->hasParam("botNumber", true))
+        int player, botNumber;
+        FormParameter parameters[] = { { "player", &player }, { "botNumber", &botNumber } };
+        if(readParameters(request, parameters, 2))
         {
-            this->command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::AssignPlayer,
-                request->getParam("player", true)->value() + ":" + request->getParam("botNumber", true)->value());
-            request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+            sendQueued(request, this->command->AddAssignPlayerCommandToQueue(player, botNumber));
         }
         else 
         {
@@ -59,10 +110,11 @@ void Webserver::ServerStart()
 
     // Receives damage
     server->on("/takeDamage", HTTP_PUT, [this](AsyncWebServerRequest *request) {
-        if(request->hasParam("magnitude", true))
+        int magnitude;
+        FormParameter parameters[] = { { "magnitude", &magnitude } };
+        if(readParameters(request, parameters, 1))
         {
-            this->command->AddDamageCommandToQueue(request->getParam("magnitude", true)->value().toInt());
-            request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+            sendQueued(request, this->command->AddDamageCommandToQueue(magnitude));
         }
         else 
         {
@@ -72,17 +124,17 @@ void Webserver::ServerStart()
 
     // Receives reset command
     server->on("/reset", HTTP_PUT, [this](AsyncWebServerRequest *request) {
-        this->command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::Reset);
-        request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+        sendQueued(request, this->command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::Reset));
     });
 
     // Receives an instruction in setup mode
     server->on("/setupInstruction", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        if(request->hasParam("option", true) && request->hasParam("parameters", true)) 
+        int option;
+        FormParameter parameters[] = { { "option", &option } };
+        AsyncWebParameter* settings = request->getParam("parameters", true);
+        if(settings != NULL && readParameters(request, parameters, 1)) 
         {
-            int option = request->getParam("option", true)->value().toInt();
-            this->command->AddSetupCommandToQueue((CommandProcessor::SetupCommands)option, request->getParam("parameters", true)->value());
-            request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+            sendQueued(request, this->command->AddSetupCommandToQueue((CommandProcessor::SetupCommands)option, settings->value()));
         }
          else 
         {
@@ -90,9 +142,148 @@ void Webserver::ServerStart()
         }
     });
 
-    // Returns the current robot settings
+    // Returns the results of the last automatic servo calibration
+    server->on("/calibration", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->command->GetCalibration());
+    });
+
+    // Returns the heading drift at rest, cold and warm, and the gyro bias model
+    server->on("/gyroDrift", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->command->GetGyroDrift());
+    });
+
+    // Returns the measured servo velocity tables
+    server->on("/velocityTables", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->config->getVelocityTables());
+    });
+
+    // Lists the stored tuning profiles
+    server->on("/profiles", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->config->getProfiles());
+    });
+
+    // Selects or saves a tuning profile
+    server->on("/profiles", HTTP_PUT, [this](AsyncWebServerRequest *request) {
+        AsyncWebParameter* name = request->getParam("name", true);
+        AsyncWebParameter* action = request->getParam("action", true);
+        if (name != NULL && action != NULL && (action->value() == "select" || action->value() == "save")) 
+        {
+            CommandProcessor::ConfigCommands profileCommand = action->value() == "select" ? CommandProcessor::ConfigCommands::SelectProfile : CommandProcessor::ConfigCommands::SaveProfile;
+            sendQueued(request, this->command->AddProfileCommandToQueue(profileCommand, name->value()));
+        }
+        else 
+        {
+            request->send(400, "text/plain", "No or bad profile data found.");
+        }
+    });
+
+    // Returns the state of the clock synchronization with the game server
+    server->on("/clock", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->communication->getClockStatus());
+    });
+
+    // Returns the current robot settings, tagged with the settings version so unchanged settings aren't resent
     server->on("/getSettings", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        request->send(HTTP_CODE_OK, "text/plain", this->config->getSettings());
+        String etag = this->config->getSettingsTag();
+        AsyncWebHeader* cached = request->getHeader("If-None-Match");
+        if (cached != NULL && cached->value() == etag)
+        {
+            request->send(HTTP_CODE_NOT_MODIFIED);
+            return;
+        }
+        AsyncWebServerResponse *response = request->beginResponse(HTTP_CODE_OK, "text/plain", this->config->getSettings());
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+    });
+
+    // Returns the settings storage counters
+    server->on("/storageStats", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->config->getStorageStatistics());
+    });
+
+    // Returns heap, stack and CPU load measurements
+    server->on("/health", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", this->health->getHealth());
+    });
+
+    // Returns when each boot phase finished and the time from power-on to ready
+    server->on("/boot", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(HTTP_CODE_OK, "application/json", BootTimeline::getTimeline());
+    });
+
+    // Downloads the control loop samples of recent moves
+    server->on("/flightRecorder", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        this->sendFlightRecord(request);
+    });
+
+#ifdef RUCKUS_PROFILING
+    // Returns the timing statistics of the profiling probes in microseconds
+    server->on("/probes", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        Profiler::writeStatistics(*response);
+        request->send(response);
+    });
+
+    // Clears the profiling statistics
+    server->on("/probes", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+        Profiler::reset();
+        request->send(HTTP_CODE_OK, "text/plain", "OK");
+    });
+
+    // Returns the last few seconds of probes as Chrome trace event JSON
+    server->on("/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        Profiler::writeTrace(*response);
+        request->send(response);
+    });
+#endif
+
+    // Replays moves against the simulator, only in setup mode. Takes an optional JSON array of scenarios
+    server->on("/replay", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        AsyncWebParameter* scenarios = request->getParam("scenarios", true);
+        sendQueued(request, this->command->AddSetupCommandToQueue(CommandProcessor::SetupCommands::Replay, scenarios != NULL ? scenarios->value() : ""));
+    });
+
+    // Returns the replay results, failing if any scenario exceeded its limits
+    server->on("/replay", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        bool passed;
+        String results = this->command->GetReplayResults(passed);
+        request->send(passed ? HTTP_CODE_OK : 500, "application/json", results);
+    });
+
+#ifdef RUCKUS_BENCHMARK
+    // Runs the benchmark suite, only in setup mode
+    server->on("/benchmark", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        sendQueued(request, this->command->AddSetupCommandToQueue(CommandProcessor::SetupCommands::RunBenchmark, ""));
+    });
+
+    // Returns the benchmark results, failing if any hot path exceeded its budget
+    server->on("/benchmark", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        bool passed;
+        String results = this->command->GetBenchmarkResults(passed);
+        request->send(passed ? HTTP_CODE_OK : 500, "application/json", results);
+    });
+#endif
+
+    // Telemetry stream
+    server->addHandler(telemetry->getSocket());
+
+    // Log stream
+    server->addHandler(Logger::getSocket());
+
+    // Sets the telemetry rate
+    server->on("/telemetryRate", HTTP_PUT, [this](AsyncWebServerRequest *request) {
+        int rate;
+        FormParameter parameters[] = { { "rate", &rate } };
+        if(readParameters(request, parameters, 1) && this->telemetry->setRate(rate))
+        {
+            request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+        }
+        else 
+        {
+            request->send(400, "text/plain", "No or bad rate found.");
+        }
     });
 
     server->onNotFound([](AsyncWebServerRequest *request) { 
@@ -101,6 +292,75 @@ void Webserver::ServerStart()
     server->begin();
 }
 
+/// @brief Streams the flight recorder samples of recent commands as CSV or binary.
+/// Takes optional "commands" (number of recent commands, default 5) and "format" ("csv" or "binary", default csv) query parameters.
+/// @param request The request to respond to.
+void Webserver::sendFlightRecord(AsyncWebServerRequest *request)
+{
+    AsyncWebParameter* commands = request->getParam("commands");
+    AsyncWebParameter* format = request->getParam("format");
+    bool binary = format != NULL && format->value() == "binary";
+    uint32_t next = recorder->firstRecord(commands != NULL ? commands->value().toInt() : 5);
+    uint32_t end = recorder->endRecord();
+    std::shared_ptr<FlightRecordStream> stream(new FlightRecordStream());
+    stream->recorder = recorder;
+    stream->binary = binary;
+    stream->next = next;
+    stream->end = end;
+    if (!binary)
+    {
+        const char* columns = "timestamp,commandId,commandType,command,leftServo,rightServo,gyroRate,angle\n";
+        stream->pendingLength = strlen(columns);
+        memcpy(stream->pending, columns, stream->pendingLength);
+    }
+    // Samples are copied straight from the ring as the response is sent, skipping any overwritten since the request
+    AsyncWebServerResponse *response = request->beginChunkedResponse(binary ? "application/octet-stream" : "text/csv",
+        [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return stream->fill(buffer, maxLen);
+        });
+    request->send(response);
+}
+
+/// @brief Fills the next chunk of a flight record response. A line or record that doesn't fit is finished in the next chunk,
+/// since returning 0 would end the response.
+/// @param buffer Receives the chunk.
+/// @param maxLen The size of the buffer.
+/// @return The length of the chunk, 0 once every sample has been sent.
+size_t Webserver::FlightRecordStream::fill(uint8_t* buffer, size_t maxLen)
+{
+    size_t length = 0;
+    while (length < maxLen)
+    {
+        if (pendingSent < pendingLength)
+        {
+            size_t part = min(pendingLength - pendingSent, maxLen - length);
+            memcpy(buffer + length, pending + pendingSent, part);
+            pendingSent += part;
+            length += part;
+            continue;
+        }
+        if (next >= end)
+        {
+            break;
+        }
+        FlightRecorder::Record record;
+        if (recorder->read(next++, record))
+        {
+            pendingSent = 0;
+            if (binary)
+            {
+                memcpy(pending, &record, sizeof(FlightRecorder::Record));
+                pendingLength = sizeof(FlightRecorder::Record);
+            }
+            else
+            {
+                pendingLength = FlightRecorder::formatCSV(record, pending, sizeof(pending));
+            }
+        }
+    }
+    return length;
+}
+
 /// @brief Stops the update server
 void Webserver::ServerStop()
 {
@@ -109,8 +369,65 @@ void Webserver::ServerStop()
     server->end();
 }
 
+/// @brief Reads form parameters from a request in a single pass over its parameters.
+/// @param request The request to read.
+/// @param parameters The parameters to find, each receives its value.
+/// @param count The number of parameters.
+/// @return True if all the parameters that aren't optional were found.
+bool Webserver::readParameters(AsyncWebServerRequest *request, FormParameter parameters[], size_t count)
+{
+    // Bit masks of the parameters found so far, so repeated parameters are only counted once, and of those required
+    uint32_t found = 0;
+    uint32_t all = (1UL << count) - 1;
+    uint32_t required = 0;
+    for (size_t j = 0; j < count; j++)
+    {
+        required |= parameters[j].optional ? 0 : 1UL << j;
+    }
+    for (size_t i = 0; i < request->params() && found != all; i++)
+    {
+        AsyncWebParameter* parameter = request->getParam(i);
+        if (!parameter->isPost())
+        {
+            continue;
+        }
+        for (size_t j = 0; j < count; j++)
+        {
+            if (parameter->name() == parameters[j].name)
+            {
+                if (parameters[j].integer != NULL)
+                {
+                    *parameters[j].integer = parameter->value().toInt();
+                }
+                else
+                {
+                    *parameters[j].number = strtod(parameter->value().c_str(), NULL);
+                }
+                found |= 1UL << j;
+                break;
+            }
+        }
+    }
+    return (found & required) == required;
+}
+
+/// @brief Replies to a request that queues a command.
+/// @param request The request.
+/// @param queued True if the command was queued, false if the queue was full and it was dropped.
+void Webserver::sendQueued(AsyncWebServerRequest *request, bool queued)
+{
+    if (queued)
+    {
+        request->send(HTTP_CODE_ACCEPTED, "text/plain", "OK");
+    }
+    else
+    {
+        request->send(HTTP_CODE_SERVICE_UNAVAILABLE, "text/plain", "Command queue full");
+    }
+}
+
 /// @brief Handle firmware update
-/// @param request
+/// @param request The request, an expected SHA-256 can be given in its X-Firmware-SHA256 header
 /// @param filename
 /// @param index
 /// @param data
@@ -120,29 +437,20 @@ void Webserver::onUpdate(AsyncWebServerRequest *request, String filename, size_t
 {
     if (!index)
     {
-        Serial.printf("Update Start: %s\n", filename.c_str());
-        // Ensure firmware will fit into flash space
-        if (!Update.begin((ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000))
+        Logger::info("Update Start: %s", filename.c_str());
+        AsyncWebHeader* hash = request->getHeader("X-Firmware-SHA256");
+        if (updater.begin(hash != NULL ? hash->value() : String(), request, request->client()))
         {
-            Update.printError(Serial);
-        }
-    }
-    if (!Update.hasError())
-    {
-        if (Update.write(data, len) != len)
-        {
-            Update.printError(Serial);
+            // Free the updater for the next upload if this one is cut off
+            request->onDisconnect([this, request]() {
+                this->updater.abort(request);
+            });
         }
     }
+    // Data from a request refused at the start is dropped
+    updater.write(request, data, len);
     if (final)
     {
-        if (Update.end(true))
-        {
-            Serial.printf("Update Success: %uB\n", index + len);
-        }
-        else
-        {
-            Update.printError(Serial);
-        }
+        updater.end(request);
     }
 }
@@ -0,0 +1,46 @@
+"""
+Compresses index.html into ../src/IndexPage.h so the firmware page is served from flash.
+Run this after editing index.html: python build_page.py
+
+This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+"""
+
+import gzip
+import hashlib
+import os
+
+here = os.path.dirname(os.path.abspath(__file__))
+
+with open(os.path.join(here, "index.html"), "rb") as page:
+    html = page.read()
+
+# A fixed mtime keeps the output, and so the ETag, identical between runs
+compressed = gzip.compress(html, compresslevel=9, mtime=0)
+etag = hashlib.sha256(compressed).hexdigest()[:16]
+
+lines = []
+for i in range(0, len(compressed), 16):
+    lines.append("    " + ", ".join("0x%02x" % b for b in compressed[i:i + 16]) + ",")
+
+with open(os.path.join(here, "..", "src", "IndexPage.h"), "w", newline="\n") as header:
+    header.write("""/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Generated by lib/Webserver/web/build_page.py from lib/Webserver/web/index.html, do not edit.
+ * Uncompressed size: %d bytes
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/// @brief ETag identifying this version of the page
+const char indexPageETag[] = "\\"%s\\"";
+
+/// @brief Length of the compressed page in bytes
+const size_t indexPageLength = %d;
+
+/// @brief Gzip compressed firmware update page, stored in flash
+const uint8_t indexPage[] PROGMEM = {
+%s
+};
+""" % (len(html), etag, len(compressed), "\n".join(lines)))
@@ -22,7 +22,7 @@ void WiFiConfig::saveConfigCallback()
 void WiFiConfig::configModeCallback(AsyncWiFiManager *myWiFiManager)
 {
     Serial.println("Access point started");
-    command->AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)RuckusBot::images::Duck) + ":1");
+    command->AddImageCommandToQueue(RuckusBot::images::Duck, true);
 }
 
 
@@ -25,6 +25,15 @@
 #include <WiFiConfig.h>
 #include <HTTPCommunication.h>
 #include <CommandProcessor.h>
+#include <BinaryCommandChannel.h>
+#include <Telemetry.h>
+#include <Battery.h>
+#include <FlightRecorder.h>
+#include <HealthMonitor.h>
+#include <Logger.h>
+#include <Buttons.h>
+#include <BootTimeline.h>
+#include <WarmRestart.h>
 
 // Global definitions
 
@@ -49,17 +58,38 @@ Configuration config;
 /// @brief HTTPCommunication object
 HTTPCommunication communicator(&config);
 
+/// @brief Recent control loop samples
+FlightRecorder recorder;
+
+/// @brief Telemetry publisher
+Telemetry telemetry(&recorder);
+
+/// @brief Battery voltage monitor
+Battery battery(&config, &telemetry);
+
 /// @brief RuckusBot object
-RuckusBot robot(&config, &communicator);
+RuckusBot robot(&config, &communicator, &telemetry, &battery);
 
 /// @brief AsyncWebServer object (passed to WfiFi manager and WebServer)
 AsyncWebServer server(80);
 
+/// @brief Plant model for replaying moves
+Simulator simulator(&config, &recorder);
+
 /// @brief Async command processor
-CommandProcessor command(&robot, &config, &communicator);
+CommandProcessor command(&robot, &config, &communicator, &telemetry, &battery, &simulator);
+
+/// @brief Heap, stack and CPU load monitor
+HealthMonitor health;
 
 /// @brief Local web server.
-Webserver WebServer(&config, &command, &server);
+Webserver WebServer(&config, &command, &server, &telemetry, &communicator, &recorder, &health);
+
+/// @brief Binary UDP command channel.
+BinaryCommandChannel channel(&command);
+
+/// @brief A and B button handler.
+Buttons buttons(&command, CALIBRATE_PIN, SHOW_IP_PIN);
 
 /* Global functions */
 
@@ -91,15 +121,44 @@ void setup()
     Serial.begin(115200);
     Serial.println("Starting");
 
+    // Write log messages from other tasks without blocking them
+    Logger::begin();
+
+    // Check for a game assignment kept from before a reset
+    bool warm = WarmRestart::begin();
+    BootTimeline::setWarmRestart(warm);
+    // Copied since showing other images while connecting replaces it
+    RuckusBot::images restoredImage = (RuckusBot::images)WarmRestart::getImage();
+
+    // Start monitoring heap, stacks and CPU load
+    health.begin();
+
     // Mount file system
     mountSPIFFS();
+    BootTimeline::mark("File system mounted");
 
-    // Initialize robot
+    // Initialize robot, this starts the gyro calibration in the background
     robot.begin();
+    BootTimeline::mark("Robot initialized");
+
+    // Restore the assignment and display straight away after a warm restart
+    if (warm)
+    {
+        config.BotConfig.PlayerNumber = WarmRestart::getPlayer();
+        config.BotConfig.RobotNumber = WarmRestart::getRobotNumber();
+        robot.showImage(restoredImage, (RuckusBot::colors)config.TunableBotSettings["robotColor"].value);
+        BootTimeline::mark("Game state restored");
+    }
+
+    // Start measuring the battery voltage, uses the loaded settings
+    battery.begin();
 
     // Start command processor loop (8K of stack depth is probably overkill, but it does process large JSON strings and we have the RAM so better safe)
     xTaskCreate(CommandProcessor::CommandProcessorTaskWrapper, "Command Processor Loop", 8192, &command, 1, NULL);
 
+    // Start sending telemetry to subscribers
+    telemetry.begin();
+
     // Check for reset of WiFi Settings
     if (digitalRead(RESET_PIN) == LOW)
     {
@@ -108,7 +167,7 @@ void setup()
         WiFi.persistent(true);
         WiFi.disconnect(true, true);
         WiFi.persistent(false);
-        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)RuckusBot::images::Check) + ":1");
+        command.AddImageCommandToQueue(RuckusBot::images::Check, true);
         delay(2000);
         ESP.restart();
     }
@@ -119,10 +178,10 @@ void setup()
     WiFiConfig configurator(&manager, &command, &config);
     // Load saved network settings and connect to Wi-Fi
     configurator.connectWiFi();
-    
-    // Assign pins
-    pinMode(SHOW_IP_PIN, INPUT_PULLUP);
-    pinMode(CALIBRATE_PIN, INPUT_PULLUP);
+    BootTimeline::mark("Wi-Fi connected");
+
+    // Moves and calibration share the gyro's I2C bus, so finish calibrating before accepting commands
+    robot.waitForGyro();
 
     // Clear server settings just in case
     WebServer.ServerStop();
@@ -130,15 +189,34 @@ void setup()
     // Start the update server
     WebServer.ServerStart();
 
-    // Join the game and make the robot ready to play
-    while (!communicator.JoinGame(config.BotConfig.RobotName) && !WebServer.shouldReboot)
+    // Start the binary command channel
+    channel.begin();
+    BootTimeline::mark("Servers started");
+
+    // Join the game and make the robot ready to play, asking to keep any restored assignment
+    while (!communicator.JoinGame(config.BotConfig.RobotName, battery.getVoltage(), config.BotConfig.PlayerNumber, config.BotConfig.RobotNumber) && !WebServer.shouldReboot)
     {
         // Failed to join game, try again after a second.
         command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::NotReady);
         delay(1000);
     }
     // Success!
-    command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::Ready);
+    if (warm)
+    {
+        // Show the player again rather than waiting to be assigned
+        command.AddImageCommandToQueue(restoredImage, true);
+    }
+    else
+    {
+        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::Ready);
+    }
+    BootTimeline::ready();
+
+    // Keep the clock synchronized with the game server for scheduled moves
+    communicator.beginClockSync();
+
+    // Start handling the A and B buttons
+    buttons.begin();
 }
 
 /// @brief Run-forever loop
@@ -148,24 +226,13 @@ void loop()
     if (WebServer.shouldReboot)
     {
         Serial.println("Firmware updated, rebooting...");
-        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)RuckusBot::images::Check) + ":1");
+        command.AddImageCommandToQueue(RuckusBot::images::Check, true);
         // Delay to show image and let server send response
         delay(5000);
+        config.flushSettings(true);
         ESP.restart();
     }
 
-    // Check if the calibrate gyro button was pushed
-    if (digitalRead(CALIBRATE_PIN) == LOW)
-    {
-        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)RuckusBot::images::Duck) + ":0");
-        robot.calibrateGyro();
-        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)robot.currentImage) + ":1");
-    }
-
-    // Check if the show IP pin has been pushed
-    if (digitalRead(SHOW_IP_PIN) == LOW)
-    {
-        robot.showIP();
-        command.AddCommandToQueue(CommandProcessor::CommandTypes::Config, CommandProcessor::ConfigCommands::UpdateImage, String((int)robot.currentImage) + ":1");
-    }
+    // Buttons are handled by interrupts, so just sleep between reboot checks
+    delay(250);
 }
\ No newline at end of file
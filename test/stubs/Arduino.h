@@ -0,0 +1,387 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the Arduino core, just enough for the firmware libraries to build and run natively under test.
+ * Time is the host's monotonic clock plus a virtual offset: delay() advances the offset instead of sleeping,
+ * so motion loops finish instantly while still seeing the time they waited.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+
+#define B00000 0
+#define B00001 1
+#define B00010 2
+#define B00011 3
+#define B00100 4
+#define B00101 5
+#define B00110 6
+#define B00111 7
+#define B01000 8
+#define B01001 9
+#define B01010 10
+#define B01011 11
+#define B01100 12
+#define B01101 13
+#define B01110 14
+#define B01111 15
+#define B10000 16
+#define B10001 17
+#define B10010 18
+#define B10011 19
+#define B10100 20
+#define B10101 21
+#define B10110 22
+#define B10111 23
+#define B11000 24
+#define B11001 25
+#define B11010 26
+#define B11011 27
+#define B11100 28
+#define B11101 29
+#define B11110 30
+#define B11111 31
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define DEC 10
+#define HEX 16
+#define ADC_11db 3
+#define IRAM_ATTR
+#define PROGMEM
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define digitalPinToInterrupt(pin) (pin)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::abs;
+using std::min;
+using std::max;
+
+/// @brief Arduino string, backed by a std::string.
+class String
+{
+    public:
+        String() {}
+        String(const char* value) : s(value != NULL ? value : "") {}
+        String(const std::string& value) : s(value) {}
+        String(char value) : s(1, value) {}
+        String(int value, unsigned char base = 10) { format(base == 16 ? "%x" : "%d", value); }
+        String(unsigned int value, unsigned char base = 10) { format(base == 16 ? "%x" : "%u", value); }
+        String(long value, unsigned char base = 10) { format(base == 16 ? "%lx" : "%ld", value); }
+        String(unsigned long value, unsigned char base = 10) { format(base == 16 ? "%lx" : "%lu", value); }
+        String(long long value) { format("%lld", value); }
+        String(unsigned long long value) { format("%llu", value); }
+        String(float value, unsigned int decimals = 2) { format("%.*f", decimals, (double)value); }
+        String(double value, unsigned int decimals = 2) { format("%.*f", decimals, value); }
+
+        unsigned int length() const { return s.size(); }
+        const char* c_str() const { return s.c_str(); }
+        bool reserve(unsigned int size) { s.reserve(size); return true; }
+        long toInt() const { return atol(s.c_str()); }
+        float toFloat() const { return atof(s.c_str()); }
+        double toDouble() const { return atof(s.c_str()); }
+        String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+        String substring(unsigned int from, unsigned int to) const
+        {
+            if (from > to)
+            {
+                std::swap(from, to);
+            }
+            return from < s.size() ? String(s.substr(from, to - from)) : String();
+        }
+        int indexOf(char value, unsigned int from = 0) const { return found(s.find(value, from)); }
+        int indexOf(const char* value, unsigned int from = 0) const { return found(s.find(value, from)); }
+        int indexOf(const String& value, unsigned int from = 0) const { return found(s.find(value.s, from)); }
+        int lastIndexOf(char value) const { return found(s.rfind(value)); }
+        bool startsWith(const char* prefix) const { return s.rfind(prefix, 0) == 0; }
+        bool startsWith(const String& prefix) const { return s.rfind(prefix.s, 0) == 0; }
+        bool endsWith(const String& suffix) const { return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0; }
+        bool equals(const String& other) const { return s == other.s; }
+        bool equals(const char* other) const { return s == other; }
+        bool equalsIgnoreCase(const String& other) const { return strcasecmp(s.c_str(), other.c_str()) == 0; }
+        void trim()
+        {
+            size_t first = s.find_first_not_of(" \t\r\n");
+            size_t last = s.find_last_not_of(" \t\r\n");
+            s = first == std::string::npos ? std::string() : s.substr(first, last - first + 1);
+        }
+        void toLowerCase() { for (char& c : s) c = tolower(c); }
+        void toUpperCase() { for (char& c : s) c = toupper(c); }
+        void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+        void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+        void replace(const String& from, const String& to)
+        {
+            for (size_t at = s.find(from.s); !from.s.empty() && at != std::string::npos; at = s.find(from.s, at + to.s.size()))
+            {
+                s.replace(at, from.s.size(), to.s);
+            }
+        }
+        bool concat(const String& value) { s += value.s; return true; }
+        bool concat(const char* value) { s += value; return true; }
+        bool concat(const char* value, unsigned int length) { s.append(value, length); return true; }
+        bool concat(char value) { s += value; return true; }
+        void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const { getBytes((unsigned char*)buffer, size, index); }
+        void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const
+        {
+            if (size == 0)
+            {
+                return;
+            }
+            size_t count = index < s.size() ? std::min<size_t>(size - 1, s.size() - index) : 0;
+            memcpy(buffer, s.data() + std::min<size_t>(index, s.size()), count);
+            buffer[count] = 0;
+        }
+        char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+        char operator[](unsigned int index) const { return charAt(index); }
+        char& operator[](unsigned int index) { return s[index]; }
+
+        String& operator+=(const String& value) { s += value.s; return *this; }
+        String& operator+=(const char* value) { s += value; return *this; }
+        String& operator+=(char value) { s += value; return *this; }
+        String& operator+=(int value) { s += std::to_string(value); return *this; }
+        String& operator+=(unsigned int value) { s += std::to_string(value); return *this; }
+        String& operator+=(long value) { s += std::to_string(value); return *this; }
+        String& operator+=(unsigned long value) { s += std::to_string(value); return *this; }
+        String& operator+=(float value) { return *this += String(value); }
+        String& operator+=(double value) { return *this += String(value); }
+        bool operator==(const String& other) const { return s == other.s; }
+        bool operator==(const char* other) const { return s == other; }
+        bool operator!=(const String& other) const { return s != other.s; }
+        bool operator!=(const char* other) const { return s != other; }
+        bool operator<(const String& other) const { return s < other.s; }
+
+        /// @brief Lets ArduinoJson and standard algorithms read the string.
+        const char* begin() const { return s.c_str(); }
+        const char* end() const { return s.c_str() + s.size(); }
+
+        /// @brief Lets ArduinoJson write into the string.
+        size_t write(uint8_t c) { s += (char)c; return 1; }
+        size_t write(const uint8_t* data, size_t size) { s.append((const char*)data, size); return size; }
+
+    private:
+        std::string s;
+
+        template <typename T>
+        void format(const char* pattern, T value)
+        {
+            char buffer[40];
+            snprintf(buffer, sizeof(buffer), pattern, value);
+            s = buffer;
+        }
+
+        void format(const char* pattern, unsigned int decimals, double value)
+        {
+            char buffer[340];
+            snprintf(buffer, sizeof(buffer), pattern, decimals, value);
+            s = buffer;
+        }
+
+        static int found(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+};
+
+inline String operator+(const String& a, const String& b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, const char* b) { String result(a); result += b; return result; }
+inline String operator+(const char* a, const String& b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, char b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, int b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, unsigned int b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, long b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, unsigned long b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, float b) { String result(a); result += b; return result; }
+inline String operator+(const String& a, double b) { String result(a); result += b; return result; }
+inline bool operator==(const char* a, const String& b) { return b == a; }
+
+/// @brief Text output, printed to stdout only when RUCKUS_NATIVE_VERBOSE is defined so test output stays readable.
+class Print
+{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) { return write(&c, 1); }
+        virtual size_t write(const uint8_t* data, size_t size)
+        {
+            #ifdef RUCKUS_NATIVE_VERBOSE
+            fwrite(data, 1, size, stdout);
+            #endif
+            return size;
+        }
+        size_t write(const char* data, size_t size) { return write((const uint8_t*)data, size); }
+        size_t print(const String& value) { return write(value.c_str(), value.length()); }
+        size_t print(const char* value) { return write(value, strlen(value)); }
+        size_t print(char value) { return write((uint8_t)value); }
+        template <typename T>
+        size_t print(T value, int base = DEC) { return print(String(value, base)); }
+        size_t print(float value, int decimals = 2) { return print(String(value, decimals)); }
+        size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+        size_t println() { return print("\n"); }
+        template <typename T>
+        size_t println(T value) { return print(value) + println(); }
+        template <typename T>
+        size_t println(T value, int format) { return print(value, format) + println(); }
+        size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+        {
+            char buffer[256];
+            va_list args;
+            va_start(args, format);
+            int length = vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            return write(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+        }
+        int availableForWrite() { return 128; }
+        void flush() {}
+};
+
+/// @brief A readable stream, always empty on the host.
+class Stream : public Print
+{
+    public:
+        virtual int available() { return 0; }
+        virtual int read() { return -1; }
+        String readString() { return String(); }
+        size_t readBytes(char* buffer, size_t length) { return 0; }
+        size_t readBytes(uint8_t* buffer, size_t length) { return 0; }
+};
+
+/// @brief Serial port, see Print.
+class HardwareSerial : public Stream
+{
+    public:
+        void begin(unsigned long baud) {}
+};
+
+inline HardwareSerial Serial;
+
+/// @brief An IPv4 address.
+class IPAddress
+{
+    public:
+        IPAddress() {}
+        IPAddress(uint32_t value) : address(value) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+        operator uint32_t() const { return address; }
+        uint8_t operator[](int index) const { return address >> (index * 8); }
+        bool fromString(const char* text)
+        {
+            unsigned int parts[4];
+            if (sscanf(text, "%u.%u.%u.%u", &parts[0], &parts[1], &parts[2], &parts[3]) != 4)
+            {
+                return false;
+            }
+            *this = IPAddress(parts[0], parts[1], parts[2], parts[3]);
+            return true;
+        }
+        bool fromString(const String& text) { return fromString(text.c_str()); }
+        String toString() const
+        {
+            char buffer[16];
+            snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+            return String(buffer);
+        }
+
+    private:
+        uint32_t address = 0;
+};
+
+/// @brief Chip information, reporting a fixed healthy heap on the host.
+class EspClass
+{
+    public:
+        void restart() { exit(0); }
+        uint32_t getFreeHeap() { return 200000; }
+        uint32_t getMinFreeHeap() { return 180000; }
+        uint32_t getMaxAllocHeap() { return 110000; }
+        uint32_t getHeapSize() { return 320000; }
+        uint32_t getFreeSketchSpace() { return 1966080; }
+        uint32_t getSketchSize() { return 1048576; }
+        uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+        uint32_t getCycleCount() { return (uint32_t)(esp_timer_get_time() * 240); }
+        uint32_t getCpuFreqMHz() { return 240; }
+};
+
+inline EspClass ESP;
+
+inline unsigned long millis()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+inline unsigned long micros()
+{
+    return esp_timer_get_time();
+}
+
+inline void delay(unsigned long ms)
+{
+    stub::advance((int64_t)ms * 1000);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+    stub::advance(us);
+}
+
+namespace stub
+{
+    /// @brief Simulated pin levels, and the millivolts read on analog pins.
+    inline int pinLevels[40];
+    inline uint32_t pinMillivolts[40];
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) { if (mode == INPUT_PULLUP) stub::pinLevels[pin] = HIGH; }
+inline int digitalRead(uint8_t pin) { return stub::pinLevels[pin]; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { stub::pinLevels[pin] = value; }
+inline uint16_t analogRead(uint8_t pin) { return std::min<uint32_t>(stub::pinMillivolts[pin] * 4095 / 3300, 4095); }
+inline uint32_t analogReadMilliVolts(uint8_t pin) { return stub::pinMillivolts[pin]; }
+inline void analogSetPinAttenuation(uint8_t pin, int attenuation) {}
+inline void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {}
+inline void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {}
+inline void detachInterrupt(uint8_t pin) {}
+
+template <class T, class L, class H>
+inline T constrain(T value, L low, H high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+inline long map(long value, long fromLow, long fromHigh, long toLow, long toHigh)
+{
+    return (value - fromLow) * (toHigh - toLow) / (fromHigh - fromLow) + toLow;
+}
+
+namespace stub
+{
+    /// @brief Seed of random(), fixed so test runs repeat.
+    inline uint32_t randomState = 12345;
+
+    inline uint32_t nextRandom()
+    {
+        randomState = randomState * 1664525 + 1013904223;
+        return randomState >> 8;
+    }
+}
+
+inline void randomSeed(unsigned long seed) { stub::randomState = seed; }
+inline long random(long high) { return high > 0 ? stub::nextRandom() % high : 0; }
+inline long random(long low, long high) { return high > low ? low + random(high - low) : low; }
@@ -0,0 +1,24 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for AsyncTCP's client, counting the data left unacknowledged while it's paused.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class AsyncClient
+{
+    public:
+        /// @brief True if the data from the last receive callback is left unacknowledged.
+        bool ackDeferred = false;
+
+        void ackLater() { ackDeferred = true; }
+        size_t ack(size_t length)
+        {
+            ackDeferred = false;
+            return length;
+        }
+};
@@ -0,0 +1,100 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for AsyncUDP. Tests deliver packets by calling the registered handler with receive(),
+ * or to whichever listener is on a port with stub::deliver().
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <map>
+
+/// @brief A received datagram, keeping the reply written to it.
+class AsyncUDPPacket
+{
+    public:
+        AsyncUDPPacket(const uint8_t* data, size_t length, IPAddress address, uint16_t port) : payload(data), size(length), address(address), port(port) {}
+        uint8_t* data() { return (uint8_t*)payload; }
+        size_t length() { return size; }
+        IPAddress remoteIP() { return address; }
+        uint16_t remotePort() { return port; }
+        size_t write(const uint8_t* data, size_t length)
+        {
+            replyLength = min(length, sizeof(reply));
+            memcpy(reply, data, replyLength);
+            return replyLength;
+        }
+
+        /// @brief The last reply written, kept in the packet so replying doesn't allocate.
+        uint8_t reply[64];
+
+        /// @brief Length of the last reply, 0 if none.
+        size_t replyLength = 0;
+
+    private:
+        const uint8_t* payload;
+        size_t size;
+        IPAddress address;
+        uint16_t port;
+};
+
+class AsyncUDP;
+
+namespace stub
+{
+    /// @brief The listener on each port.
+    inline std::map<uint16_t, AsyncUDP*> udpListeners;
+}
+
+/// @brief A UDP listener.
+class AsyncUDP
+{
+    public:
+        ~AsyncUDP() { close(); }
+
+        bool listen(uint16_t port)
+        {
+            close();
+            this->port = port;
+            stub::udpListeners[port] = this;
+            return true;
+        }
+        void onPacket(std::function<void(AsyncUDPPacket&)> handler) { this->handler = handler; }
+        void close()
+        {
+            auto listener = stub::udpListeners.find(port);
+            if (listener != stub::udpListeners.end() && listener->second == this)
+            {
+                stub::udpListeners.erase(listener);
+            }
+        }
+
+        /// @brief Delivers a packet to the handler as if it was received.
+        /// @param packet The packet.
+        void receive(AsyncUDPPacket& packet) { handler(packet); }
+
+    private:
+        std::function<void(AsyncUDPPacket&)> handler;
+        uint16_t port = 0;
+};
+
+namespace stub
+{
+    /// @brief Delivers a packet to the listener on a port.
+    /// @param port The port the packet was sent to.
+    /// @param packet The packet.
+    /// @return True if something was listening.
+    inline bool deliver(uint16_t port, AsyncUDPPacket& packet)
+    {
+        auto listener = udpListeners.find(port);
+        if (listener == udpListeners.end())
+        {
+            return false;
+        }
+        listener->second->receive(packet);
+        return true;
+    }
+}
@@ -0,0 +1,29 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for ESP32Servo, remembering the last command.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class ESP32PWM
+{
+    public:
+        static void allocateTimer(int timer) {}
+};
+
+class Servo
+{
+    public:
+        void setPeriodHertz(int hertz) {}
+        int attach(int pin, int minimum, int maximum) { return 0; }
+        void write(int value) { command = value; }
+        void writeMicroseconds(int value) { command = value; }
+        int read() { return command; }
+
+    private:
+        int command = 90;
+};
@@ -0,0 +1,304 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for ESPAsyncWebServer. Routes are kept so tests can hand a request to the firmware's handlers,
+ * and requests keep the response sent to them. Form bodies are split into parameters the way the library does,
+ * with a String per name and value, so the request handling costs of the HTTP path can be compared on the host.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <HTTPClient.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+typedef enum { HTTP_GET = 0b00000001, HTTP_POST = 0b00000010, HTTP_DELETE = 0b00000100, HTTP_PUT = 0b00001000, HTTP_PATCH = 0b00010000, HTTP_HEAD = 0b00100000, HTTP_OPTIONS = 0b01000000, HTTP_ANY = 0b01111111 } WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+/// @brief A query or form parameter.
+class AsyncWebParameter
+{
+    public:
+        AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false) : _name(name), _value(value), _form(form), _file(file) {}
+        const String& name() const { return _name; }
+        const String& value() const { return _value; }
+        bool isPost() const { return _form; }
+        bool isFile() const { return _file; }
+
+    private:
+        String _name;
+        String _value;
+        bool _form;
+        bool _file;
+};
+
+/// @brief A request header.
+class AsyncWebHeader
+{
+    public:
+        AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+        const String& name() const { return _name; }
+        const String& value() const { return _value; }
+
+    private:
+        String _name;
+        String _value;
+};
+
+/// @brief A response waiting to be sent.
+class AsyncWebServerResponse
+{
+    public:
+        AsyncWebServerResponse(int code = 200, const String& contentType = String(), const String& content = String()) : code(code), contentType(contentType), content(content) {}
+        virtual ~AsyncWebServerResponse() {}
+        void addHeader(const String& name, const String& value) { headers.emplace_back(name, value); }
+        void setCode(int code) { this->code = code; }
+
+        int code;
+        String contentType;
+        String content;
+        std::vector<AsyncWebHeader> headers;
+};
+
+/// @brief A response printed into memory.
+class AsyncResponseStream : public AsyncWebServerResponse, public Print
+{
+    public:
+        AsyncResponseStream(const String& contentType) : AsyncWebServerResponse(200, contentType) {}
+        using Print::write;
+        size_t write(const uint8_t* data, size_t length) override
+        {
+            content.concat((const char*)data, length);
+            return length;
+        }
+};
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+
+/// @brief A received request.
+class AsyncWebServerRequest
+{
+    public:
+        /// @brief Data kept by upload handlers between calls.
+        void* _tempObject = NULL;
+
+        /// @brief Code of the response sent, 0 until one is sent.
+        int sentCode = 0;
+
+        /// @brief Body of the response sent.
+        String sentContent;
+
+        AsyncWebServerRequest(WebRequestMethodComposite method, const String& url) : _method(method), _url(url) {}
+        ~AsyncWebServerRequest()
+        {
+            if (disconnect)
+            {
+                disconnect();
+            }
+        }
+
+        /// @brief Adds the parameters of a form encoded body, as the library does when it parses one.
+        /// @param body The body, e.g. "move=2&magnitude=1".
+        void parseForm(const char* body)
+        {
+            while (*body != 0)
+            {
+                const char* end = strchr(body, '&');
+                size_t length = end != NULL ? end - body : strlen(body);
+                const char* equals = (const char*)memchr(body, '=', length);
+                String name, value;
+                name.concat(body, equals != NULL ? equals - body : length);
+                if (equals != NULL)
+                {
+                    value.concat(equals + 1, body + length - equals - 1);
+                }
+                addParam(new AsyncWebParameter(name, value, true));
+                body += end != NULL ? length + 1 : length;
+            }
+        }
+
+        void addParam(AsyncWebParameter* parameter) { parameters.emplace_back(parameter); }
+        void addHeader(const String& name, const String& value) { headers.emplace_back(new AsyncWebHeader(name, value)); }
+
+        AsyncClient* client() { return &_client; }
+        WebRequestMethodComposite method() const { return _method; }
+        const String& url() const { return _url; }
+        size_t contentLength() const { return 0; }
+
+        size_t params() const { return parameters.size(); }
+        AsyncWebParameter* getParam(size_t index) const { return index < parameters.size() ? parameters[index].get() : NULL; }
+        AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const
+        {
+            for (auto& parameter : parameters)
+            {
+                if (parameter->name() == name && parameter->isPost() == post && parameter->isFile() == file)
+                {
+                    return parameter.get();
+                }
+            }
+            return NULL;
+        }
+        bool hasParam(const String& name, bool post = false, bool file = false) const { return getParam(name, post, file) != NULL; }
+
+        AsyncWebHeader* getHeader(const String& name) const
+        {
+            for (auto& header : headers)
+            {
+                if (header->name().equalsIgnoreCase(name))
+                {
+                    return header.get();
+                }
+            }
+            return NULL;
+        }
+        bool hasHeader(const String& name) const { return getHeader(name) != NULL; }
+
+        void onDisconnect(std::function<void()> handler) { disconnect = handler; }
+
+        void send(int code, const String& contentType = String(), const String& content = String())
+        {
+            sentCode = code;
+            sentContent = content;
+        }
+        void send(AsyncWebServerResponse* response)
+        {
+            sentCode = response->code;
+            sentContent = response->content;
+            delete response;
+        }
+        void send_P(int code, const String& contentType, const uint8_t* content, size_t length) { send(code, contentType); }
+        AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String()) { return new AsyncWebServerResponse(code, contentType, content); }
+        AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, const uint8_t* content, size_t length) { return new AsyncWebServerResponse(code, contentType); }
+        AsyncWebServerResponse* beginResponse(const String& contentType, size_t length, AwsResponseFiller filler) { return new AsyncWebServerResponse(200, contentType); }
+        AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller filler) { return new AsyncWebServerResponse(200, contentType); }
+        AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460) { return new AsyncResponseStream(contentType); }
+
+    private:
+        AsyncClient _client;
+        WebRequestMethodComposite _method;
+        String _url;
+        std::vector<std::unique_ptr<AsyncWebParameter>> parameters;
+        std::vector<std::unique_ptr<AsyncWebHeader>> headers;
+        std::function<void()> disconnect;
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, const String&, size_t, uint8_t*, size_t, bool)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)> ArBodyHandlerFunction;
+
+/// @brief Base of the handlers added to a server.
+class AsyncWebHandler
+{
+    public:
+        virtual ~AsyncWebHandler() {}
+};
+
+/// @brief A route and the functions handling it.
+class AsyncCallbackWebHandler : public AsyncWebHandler
+{
+    public:
+        String uri;
+        WebRequestMethodComposite method;
+        ArRequestHandlerFunction onRequest;
+        ArUploadHandlerFunction onUpload;
+        ArBodyHandlerFunction onBody;
+};
+
+class AsyncWebSocketClient
+{
+    public:
+        uint32_t id() { return 0; }
+        bool canSend() { return true; }
+        void text(const char* message) {}
+        void binary(const uint8_t* data, size_t length) {}
+};
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+class AsyncWebSocket;
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)> AwsEventHandler;
+
+/// @brief A WebSocket endpoint with no clients.
+class AsyncWebSocket : public AsyncWebHandler
+{
+    public:
+        AsyncWebSocket(const String& url) {}
+        void onEvent(AwsEventHandler handler) {}
+        size_t count() const { return 0; }
+        bool availableForWriteAll() { return true; }
+        void textAll(const char* message) {}
+        void textAll(const char* message, size_t length) {}
+        void binaryAll(const uint8_t* data, size_t length) {}
+        void binaryAll(const char* data, size_t length) {}
+        void cleanupClients(uint16_t maxClients = 8) {}
+        void closeAll(uint16_t code = 0, const char* message = NULL) {}
+};
+
+/// @brief A web server. Tests pass requests to handle(), nothing listens on the network.
+class AsyncWebServer
+{
+    public:
+        AsyncWebServer(uint16_t port) {}
+        void begin() {}
+        void end() {}
+        void reset()
+        {
+            routes.clear();
+            notFound = NULL;
+        }
+
+        AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload = NULL, ArBodyHandlerFunction onBody = NULL)
+        {
+            routes.emplace_back(new AsyncCallbackWebHandler());
+            AsyncCallbackWebHandler& route = *routes.back();
+            route.uri = uri;
+            route.method = method;
+            route.onRequest = onRequest;
+            route.onUpload = onUpload;
+            route.onBody = onBody;
+            return route;
+        }
+        AsyncWebHandler& addHandler(AsyncWebHandler* handler) { return *handler; }
+        void onNotFound(ArRequestHandlerFunction handler) { notFound = handler; }
+
+        /// @brief Finds the route for a request.
+        /// @param method The request method.
+        /// @param uri The request path.
+        /// @return The route, or NULL if none matches.
+        AsyncCallbackWebHandler* route(WebRequestMethodComposite method, const String& uri)
+        {
+            for (auto& route : routes)
+            {
+                if (route->uri == uri && (route->method & method))
+                {
+                    return route.get();
+                }
+            }
+            return NULL;
+        }
+
+        /// @brief Passes a request to its route's request handler, or the not found handler.
+        /// @param request The request.
+        void handle(AsyncWebServerRequest* request)
+        {
+            AsyncCallbackWebHandler* found = route(request->method(), request->url());
+            if (found != NULL)
+            {
+                found->onRequest(request);
+            }
+            else if (notFound)
+            {
+                notFound(request);
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<AsyncCallbackWebHandler>> routes;
+        ArRequestHandlerFunction notFound;
+};
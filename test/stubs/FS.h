@@ -0,0 +1,34 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the flash file system, which is empty.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+namespace fs
+{
+    /// @brief An open file, never valid on the host.
+    class File : public Stream
+    {
+        public:
+            operator bool() const { return false; }
+            size_t size() { return 0; }
+            void close() {}
+    };
+
+    /// @brief A file system with no files.
+    class FS
+    {
+        public:
+            File open(const char* path, const char* mode = "r") { return File(); }
+            bool exists(const char* path) { return false; }
+            bool remove(const char* path) { return false; }
+            bool rename(const char* from, const char* to) { return false; }
+    };
+}
+
+using fs::File;
@@ -0,0 +1,47 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for FastLED, the LEDs are plain memory.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/// @brief An RGB color.
+struct CRGB
+{
+    uint8_t r = 0, g = 0, b = 0;
+    CRGB() {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+};
+
+/// @brief A fixed size array of LEDs.
+template <int Size>
+struct CRGBArray
+{
+    CRGB leds[Size];
+    static const int len = Size;
+    CRGB& operator[](int index) { return leds[index]; }
+    operator CRGB*() { return leds; }
+};
+
+enum ESPIChipsets { WS2812B };
+enum EOrder { RGB, GRB };
+
+/// @brief LED controller, counts frames shown.
+class CFastLED
+{
+    public:
+        /// @brief Number of calls to show().
+        uint32_t frames = 0;
+
+        template <ESPIChipsets Chipset, int Pin, EOrder Order>
+        void addLeds(CRGB* leds, int count) {}
+        void setBrightness(uint8_t brightness) {}
+        void clear() {}
+        void show() { frames++; }
+};
+
+inline CFastLED FastLED;
@@ -0,0 +1,39 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the HTTP client. There's no game server on the host, every request fails to connect.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <WiFi.h>
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_ACCEPTED 202
+#define HTTP_CODE_NO_CONTENT 204
+#define HTTP_CODE_NOT_MODIFIED 304
+#define HTTP_CODE_BAD_REQUEST 400
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTP_CODE_CONFLICT 409
+#define HTTP_CODE_PRECONDITION_FAILED 412
+#define HTTP_CODE_INTERNAL_SERVER_ERROR 500
+#define HTTP_CODE_SERVICE_UNAVAILABLE 503
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+class HTTPClient
+{
+    public:
+        bool begin(String url) { return true; }
+        void end() {}
+        void setReuse(bool reuse) {}
+        void setTimeout(uint16_t timeout) {}
+        void setConnectTimeout(int32_t timeout) {}
+        void addHeader(const String& name, const String& value) {}
+        int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+        int POST(String payload) { return HTTPC_ERROR_CONNECTION_REFUSED; }
+        int PUT(String payload) { return HTTPC_ERROR_CONNECTION_REFUSED; }
+        String getString() { return String(); }
+        int getSize() { return 0; }
+        static String errorToString(int error) { return "connection refused"; }
+};
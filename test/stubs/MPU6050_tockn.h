@@ -0,0 +1,37 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the MPU6050 gyro. Tests set the rates and temperature it reads.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Wire.h>
+
+/// @brief The MPU6050 interface used by the firmware, see https://github.com/Tockn/MPU6050_tockn
+class MPU6050
+{
+    public:
+        /// @brief Rates read on each axis in degrees per second, before the offsets are removed.
+        float rates[3] = { 0, 0, 0 };
+
+        /// @brief Temperature read in degrees Celsius.
+        float temperature = 25;
+
+        MPU6050(TwoWire& wire) {}
+        void begin() {}
+        void update() {}
+        void calcGyroOffsets(bool console = false, uint16_t delayBefore = 1000, uint16_t delayAfter = 3000) { setGyroOffsets(rates[0], rates[1], rates[2]); }
+        void setGyroOffsets(float x, float y, float z) { offsets[0] = x; offsets[1] = y; offsets[2] = z; }
+        float getGyroX() { return rates[0] - offsets[0]; }
+        float getGyroY() { return rates[1] - offsets[1]; }
+        float getGyroZ() { return rates[2] - offsets[2]; }
+        float getGyroXoffset() { return offsets[0]; }
+        float getGyroYoffset() { return offsets[1]; }
+        float getGyroZoffset() { return offsets[2]; }
+        float getTemp() { return temperature; }
+
+    private:
+        float offsets[3] = { 0, 0, 0 };
+};
@@ -0,0 +1,71 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the ESP32 NVS preferences, kept in memory for the life of the test program.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace stub
+{
+    /// @brief Stored values by namespace and key.
+    inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> preferences;
+}
+
+/// @brief Key-value storage, see the ESP32 Preferences library.
+class Preferences
+{
+    public:
+        bool begin(const char* name, bool readOnly = false)
+        {
+            space = &stub::preferences[name];
+            return true;
+        }
+        void end() { space = NULL; }
+        bool clear() { space->clear(); return true; }
+        bool remove(const char* key) { return space->erase(key) > 0; }
+        bool isKey(const char* key) { return space->count(key) > 0; }
+        size_t putBytes(const char* key, const void* value, size_t length)
+        {
+            (*space)[key].assign((const uint8_t*)value, (const uint8_t*)value + length);
+            return length;
+        }
+        size_t getBytesLength(const char* key) { return isKey(key) ? (*space)[key].size() : 0; }
+        size_t getBytes(const char* key, void* buffer, size_t length)
+        {
+            size_t stored = getBytesLength(key);
+            if (stored == 0 || stored > length)
+            {
+                return 0;
+            }
+            memcpy(buffer, (*space)[key].data(), stored);
+            return stored;
+        }
+        size_t putChar(const char* key, int8_t value) { return putBytes(key, &value, sizeof(value)); }
+        int8_t getChar(const char* key, int8_t defaultValue = 0) { return get(key, defaultValue); }
+        size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+        uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+        size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+        uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+        size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+        float getFloat(const char* key, float defaultValue = 0) { return get(key, defaultValue); }
+        size_t putString(const char* key, const String& value) { return putBytes(key, value.c_str(), value.length() + 1); }
+        String getString(const char* key, const String& defaultValue = String()) { return isKey(key) ? String((const char*)(*space)[key].data()) : defaultValue; }
+        size_t freeEntries() { return 500; }
+
+    private:
+        std::map<std::string, std::vector<uint8_t>>* space = NULL;
+
+        template <typename T>
+        T get(const char* key, T defaultValue)
+        {
+            T value;
+            return getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+        }
+};
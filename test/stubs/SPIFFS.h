@@ -0,0 +1,21 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for SPIFFS, see FS.h.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <FS.h>
+
+class SPIFFSFS : public fs::FS
+{
+    public:
+        bool begin(bool formatOnFail = false) { return true; }
+        bool format() { return true; }
+        size_t totalBytes() { return 0; }
+        size_t usedBytes() { return 0; }
+};
+
+inline SPIFFSFS SPIFFS;
@@ -0,0 +1,31 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the OTA updater, accepting everything written to it.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+class UpdateClass
+{
+    public:
+        bool begin(size_t size = UPDATE_SIZE_UNKNOWN) { running = true; return true; }
+        size_t write(uint8_t* data, size_t length) { return length; }
+        bool end(bool evenIfRemaining = false) { running = false; return true; }
+        void abort() { running = false; }
+        bool isRunning() { return running; }
+        bool hasError() { return false; }
+        uint8_t getError() { return 0; }
+        const char* errorString() { return ""; }
+        void printError(Print& out) {}
+
+    private:
+        bool running = false;
+};
+
+inline UpdateClass Update;
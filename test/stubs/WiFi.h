@@ -0,0 +1,28 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the Wi-Fi station.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define WIFI_STA 1
+#define WIFI_AP_STA 3
+#define WL_CONNECTED 3
+
+class WiFiClass
+{
+    public:
+        IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+        void mode(int mode) {}
+        void persistent(bool persistent) {}
+        bool disconnect(bool wifiOff = false, bool eraseAp = false) { return true; }
+        int status() { return WL_CONNECTED; }
+        int8_t RSSI() { return -60; }
+        String macAddress() { return "F6:E5:D4:C3:B2:A1"; }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,18 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the I2C bus.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class TwoWire
+{
+    public:
+        bool begin(int sda, int scl) { return true; }
+};
+
+inline TwoWire Wire;
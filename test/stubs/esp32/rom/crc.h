@@ -0,0 +1,24 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the ROM CRC, the same little-endian CRC-32 as the ESP32 ROM.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+
+inline uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 1 ? crc >> 1 ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,17 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the FreeRTOS idle hooks, which never run on the host.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+
+typedef bool (*esp_freertos_idle_cb_t)();
+
+inline int esp_register_freertos_idle_hook_for_cpu(esp_freertos_idle_cb_t hook, unsigned int cpu)
+{
+    return 0;
+}
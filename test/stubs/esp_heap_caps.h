@@ -0,0 +1,18 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the ESP-IDF heap functions, reporting a fixed healthy heap.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return 110000; }
+inline size_t heap_caps_get_free_size(uint32_t caps) { return 200000; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 180000; }
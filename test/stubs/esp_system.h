@@ -0,0 +1,24 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the ESP-IDF system functions.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+#include <Arduino.h>
+
+typedef enum { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO } esp_reset_reason_t;
+
+inline esp_reset_reason_t esp_reset_reason()
+{
+    return ESP_RST_POWERON;
+}
+
+/// @brief Random numbers from the seeded random() so test runs repeat.
+inline uint32_t esp_random()
+{
+    return stub::nextRandom() << 8 ^ stub::nextRandom();
+}
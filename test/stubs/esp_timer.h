@@ -0,0 +1,32 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for the ESP-IDF timer, see Arduino.h for how time passes.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+namespace stub
+{
+    /// @brief Time skipped by delays, in microseconds.
+    inline int64_t skipped = 0;
+
+    /// @brief Host time the program started at.
+    inline const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    /// @brief Moves the clock forward without waiting.
+    /// @param us Microseconds to skip.
+    inline void advance(int64_t us)
+    {
+        skipped += us;
+    }
+}
+
+inline int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stub::started).count() + stub::skipped;
+}
@@ -0,0 +1,260 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Host stand-in for FreeRTOS. Tests run on a single thread: queues and semaphores work without blocking,
+ * created tasks never run, delays advance the clock (see Arduino.h) and critical sections do nothing.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <esp_timer.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffff
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (ms)
+#define portNUM_PROCESSORS 2
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+#define configUSE_TRACE_FACILITY 1
+#define portYIELD_FROM_ISR(...)
+
+/// @brief A spinlock, nothing to lock on a single thread.
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+typedef enum { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite } eNotifyAction;
+
+typedef struct
+{
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t* pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+/// @brief A fixed size ring buffer of copied items, allocated once like a FreeRTOS queue.
+struct QueueDefinition
+{
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::vector<uint8_t> storage;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+typedef QueueDefinition* QueueHandle_t;
+
+/// @brief A semaphore, a mutex is a binary semaphore that starts given.
+struct SemaphoreDefinition
+{
+    UBaseType_t count;
+    UBaseType_t maximum;
+};
+typedef SemaphoreDefinition* SemaphoreHandle_t;
+
+namespace stub
+{
+    /// @brief The most recently created queue, so a test can empty a queue whose consuming task never runs.
+    inline QueueHandle_t lastQueue = NULL;
+}
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    stub::lastQueue = new QueueDefinition { length, itemSize, std::vector<uint8_t>(length * itemSize), 0, 0 };
+    return stub::lastQueue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait)
+{
+    if (queue->count == queue->length)
+    {
+        return pdFALSE;
+    }
+    memcpy(&queue->storage[(queue->head + queue->count) % queue->length * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t wait)
+{
+    return xQueueSend(queue, item, wait);
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    return xQueueSend(queue, item, 0);
+}
+
+/// @brief Takes the oldest item, a wait for an empty queue passes on the clock instead of blocking.
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait)
+{
+    if (queue->count == 0)
+    {
+        stub::advance(wait == portMAX_DELAY ? 0 : (int64_t)wait * portTICK_PERIOD_MS * 1000);
+        return pdFALSE;
+    }
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    queue->head = queue->count = 0;
+    return pdPASS;
+}
+
+inline void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == stub::lastQueue)
+    {
+        stub::lastQueue = NULL;
+    }
+    delete queue;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    return queue->length - queue->count;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new SemaphoreDefinition { 0, 1 };
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new SemaphoreDefinition { 1, 1 };
+}
+
+/// @brief Takes the semaphore if it's available. Nothing else can give it while a single thread waits, so waits fail at once.
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait)
+{
+    if (semaphore->count == 0)
+    {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count == semaphore->maximum)
+    {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+/// @brief Accepts a task without running it, tests call the task's work directly.
+inline BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stack, void* arg, UBaseType_t priority, TaskHandle_t* handle)
+{
+    if (handle != NULL)
+    {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack, void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core)
+{
+    return xTaskCreate(task, name, stack, arg, priority, handle);
+}
+
+inline void vTaskDelete(TaskHandle_t task) {}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    stub::advance((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+    return esp_timer_get_time() / 1000 / portTICK_PERIOD_MS;
+}
+
+inline void vTaskDelayUntil(TickType_t* previousWake, TickType_t ticks)
+{
+    *previousWake += ticks;
+    int64_t wait = (int64_t)*previousWake * portTICK_PERIOD_MS * 1000 - esp_timer_get_time();
+    stub::advance(wait > 0 ? wait : 0);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return NULL;
+}
+
+inline UBaseType_t uxTaskGetNumberOfTasks()
+{
+    return 0;
+}
+
+inline UBaseType_t uxTaskGetSystemState(TaskStatus_t* tasks, UBaseType_t size, uint32_t* runTime)
+{
+    if (runTime != NULL)
+    {
+        *runTime = 0;
+    }
+    return 0;
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return 1024;
+}
+
+inline BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* woken)
+{
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t wait)
+{
+    stub::advance(wait == portMAX_DELAY ? 0 : (int64_t)wait * portTICK_PERIOD_MS * 1000);
+    return pdFALSE;
+}
+
+inline BaseType_t xPortGetCoreID()
+{
+    return 1;
+}
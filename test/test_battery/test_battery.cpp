@@ -0,0 +1,137 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Checks the battery compensation on the host: the speed and time factors across the voltage range, at the
+ * clamped ends of the curve, and that linear moves cover the same distance as the battery discharges.
+ * Run with: pio test -e native -f test_battery
+ *
+ * Contributors: Sam Groveman
+ */
+
+#include <unity.h>
+#include <RuckusBot.h>
+
+Configuration config;
+HTTPCommunication communicator(&config);
+FlightRecorder recorder;
+Telemetry telemetry(&recorder);
+Battery battery(&config, &telemetry);
+RuckusBot robot(&config, &communicator, &telemetry, &battery);
+
+/// @brief The ADC pin the battery is measured on in these tests.
+static const int BatteryPin = 34;
+
+void setUp()
+{
+    config.TunableBotSettings["batteryNominal"].value = 4.5;
+    config.TunableBotSettings["batterySpeedGain"].value = 0.5;
+    config.TunableBotSettings["batteryTimeGain"].value = 1;
+}
+
+void tearDown() {}
+
+/// @brief Holds the voltage at the ADC pin until the filtered voltage settles on it.
+/// @param volts The battery voltage.
+static void setVoltage(float volts)
+{
+    stub::pinMillivolts[BatteryPin] = volts * 1000 / config.TunableBotSettings["batteryDivider"].value;
+    for (int i = 0; i < 200; i++)
+    {
+        battery.sample();
+    }
+}
+
+/// @brief The factors are 1 at the nominal voltage.
+void test_nominal_voltage_not_compensated()
+{
+    setVoltage(4.5);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 4.5, battery.getVoltage());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1, battery.speedScale());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1, battery.timeScale());
+}
+
+/// @brief The speed factor follows its gain, and rises as the voltage drops.
+void test_speed_scale_across_range()
+{
+    float last = 0;
+    for (float volts = 5.2; volts >= 3.4; volts -= 0.2)
+    {
+        setVoltage(volts);
+        float expected = 1 + 0.5 * (4.5 / battery.getVoltage() - 1);
+        TEST_ASSERT_FLOAT_WITHIN(0.001, expected, battery.speedScale());
+        TEST_ASSERT_TRUE(battery.speedScale() > last);
+        last = battery.speedScale();
+    }
+}
+
+/// @brief Gains of 0 turn compensation off at any voltage.
+void test_zero_gain_not_compensated()
+{
+    config.TunableBotSettings["batterySpeedGain"].value = 0;
+    config.TunableBotSettings["batteryTimeGain"].value = 0;
+    for (float volts = 5.2; volts >= 3.4; volts -= 0.6)
+    {
+        setVoltage(volts);
+        TEST_ASSERT_FLOAT_WITHIN(0.001, 1, battery.speedScale());
+        TEST_ASSERT_FLOAT_WITHIN(0.001, 1, battery.timeScale());
+    }
+}
+
+/// @brief Far from the nominal voltage the factors stop at 0.5 and 2.
+void test_clamped_curve_ends()
+{
+    config.TunableBotSettings["batterySpeedGain"].value = 1;
+    setVoltage(1.5);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 2, battery.speedScale());
+    setVoltage(12);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5, battery.speedScale());
+    config.TunableBotSettings["batterySpeedGain"].value = 0;
+    setVoltage(1.5);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 2, battery.timeScale());
+    setVoltage(12);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5, battery.timeScale());
+}
+
+/// @brief With speed proportional to voltage, a linear move covers the same distance along a discharge curve.
+void test_distance_consistent_over_discharge()
+{
+    const float gains[][2] = { { 0.5, 1 }, { 1, 1 }, { 0, 1 }, { 0.25, 1 } };
+    for (auto& gain : gains)
+    {
+        config.TunableBotSettings["batterySpeedGain"].value = gain[0];
+        config.TunableBotSettings["batteryTimeGain"].value = gain[1];
+        for (float volts = 4.8; volts >= 3.6; volts -= 0.1)
+        {
+            setVoltage(volts);
+            // Wheel speed relative to nominal, times move time relative to nominal
+            float distance = battery.getVoltage() / 4.5 * battery.speedScale() * battery.timeScale();
+            char message[80];
+            snprintf(message, sizeof(message), "%.1fV with gains %.2f and %.2f", volts, gain[0], gain[1]);
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, 1, distance, message);
+        }
+    }
+}
+
+/// @brief Without a voltage measured the factors are 1.
+void test_unmeasured_not_compensated()
+{
+    Battery unmeasured(&config, &telemetry);
+    TEST_ASSERT_EQUAL_FLOAT(0, unmeasured.getVoltage());
+    TEST_ASSERT_EQUAL_FLOAT(1, unmeasured.speedScale());
+    TEST_ASSERT_EQUAL_FLOAT(1, unmeasured.timeScale());
+}
+
+int main()
+{
+    robot.begin();
+    config.TunableBotSettings["batteryPin"].value = BatteryPin;
+    battery.begin();
+    UNITY_BEGIN();
+    RUN_TEST(test_nominal_voltage_not_compensated);
+    RUN_TEST(test_speed_scale_across_range);
+    RUN_TEST(test_zero_gain_not_compensated);
+    RUN_TEST(test_clamped_curve_ends);
+    RUN_TEST(test_distance_consistent_over_discharge);
+    RUN_TEST(test_unmeasured_not_compensated);
+    return UNITY_END();
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Baseline cost of each benchmark on a development machine. Re-record it from the lines test_print_baseline
+ * prints after a change that deliberately makes a hot path slower, or after moving to a much slower machine.
+ * A baseline of 0 hasn't been recorded yet and isn't checked. settingsRoundTrip is mostly ArduinoJson's work,
+ * so record it from a run against the real library rather than a stand-in.
+ *
+ * Contributors: Sam Groveman
+ */
+
+#pragma once
+
+/// @brief Expected cost of one benchmark operation.
+struct Baseline
+{
+    /// @brief The benchmark name.
+    const char* name;
+    /// @brief Time per operation in nanoseconds.
+    float nanoseconds;
+    /// @brief Heap allocations per operation.
+    float allocations;
+};
+
+#ifndef BENCHMARK_TIME_TOLERANCE
+#define BENCHMARK_TIME_TOLERANCE 1.0
+#endif
+
+/// @brief Fraction a benchmark may be slower than its baseline, hosts vary so it's generous. Override with -D BENCHMARK_TIME_TOLERANCE.
+static const float TimeTolerance = BENCHMARK_TIME_TOLERANCE;
+
+/// @brief Nanoseconds a benchmark may be slower than its tolerance allows, so the fastest aren't failed by timer jitter.
+static const float TimeSlack = 50;
+
+/// @brief Fraction a benchmark may allocate more than its baseline, plus half an allocation.
+static const float AllocationTolerance = 0.25;
+
+/// @brief The baselines, one per benchmark.
+static const Baseline Baselines[] =
+{
+    { "getSettings", 100, 1.00 },
+    { "settingsRoundTrip", 0, 0.00 },
+    { "commandQueue", 140, 1.00 },
+    { "display", 60, 0.00 },
+    { "gyroIntegration", 100, 0.00 },
+    { "suppressedLog", 6, 0.00 },
+    { "moveHandler", 150, 0.00 },
+    { "assignPlayerHandler", 175, 0.00 },
+    { "httpMove", 600, 4.00 },
+    { "udpMove", 100, 0.00 },
+};
@@ -0,0 +1,307 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Runs the firmware benchmark suite natively against the stubs in test/stubs and fails any benchmark
+ * slower or allocating more than its committed baseline allows. Also compares a move sent as an HTTP request
+ * with the same move sent over the binary command channel, and checks the command handlers don't allocate.
+ * Run with: pio test -e native -f test_benchmark
+ *
+ * Contributors: Sam Groveman
+ */
+
+#include <unity.h>
+#include <Benchmark.h>
+#include <Webserver.h>
+#include <BinaryCommandChannel.h>
+#include "baseline.h"
+
+#ifdef __GLIBC__
+// Count every heap allocation made by the program, the firmware build wraps malloc in Benchmark.cpp instead
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+
+    void* malloc(size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        Benchmark::allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(pointer, size);
+    }
+}
+
+/// @brief True if allocations are counted on this host.
+static const bool CountingAllocations = true;
+#else
+static const bool CountingAllocations = false;
+#endif
+
+Configuration config;
+HTTPCommunication communicator(&config);
+FlightRecorder recorder;
+Telemetry telemetry(&recorder);
+Battery battery(&config, &telemetry);
+RuckusBot robot(&config, &communicator, &telemetry, &battery);
+Simulator simulator(&config, &recorder);
+CommandProcessor command(&robot, &config, &communicator, &telemetry, &battery, &simulator);
+Benchmark benchmark(&config, &robot, &command);
+
+/// @brief The command queue, created last by the command processor. Its task doesn't run on the host, so benchmarks empty it.
+QueueHandle_t commandQueue = stub::lastQueue;
+
+HealthMonitor health;
+AsyncWebServer server(80);
+Webserver webserver(&config, &command, &server, &telemetry, &communicator, &recorder, &health);
+BinaryCommandChannel channel(&command);
+
+/// @brief Results of the suite, run once for all the tests.
+JsonDocument results_doc;
+
+/// @brief Response code of the last move sent as an HTTP request.
+int httpCode = 0;
+
+/// @brief Status of the last move sent over the binary command channel.
+int udpStatus = -1;
+
+/// @brief Response codes of the /move and /assignPlayer handler benchmarks.
+int handlerCodes[2];
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief Finds the baseline of a benchmark.
+/// @param name The benchmark name.
+/// @return The baseline, or NULL if there isn't one.
+static const Baseline* findBaseline(const char* name)
+{
+    for (const Baseline& baseline : Baselines)
+    {
+        if (strcmp(baseline.name, name) == 0)
+        {
+            return &baseline;
+        }
+    }
+    return NULL;
+}
+
+/// @brief Checks if a baseline has been recorded.
+/// @param baseline The baseline.
+/// @return False if the benchmark isn't checked yet.
+static bool recorded(const Baseline* baseline)
+{
+    return baseline->nanoseconds > 0;
+}
+
+/// @brief Times an operation and adds it to the results the same way as the firmware suite.
+/// Keeps the fastest of a few runs, so the host scheduler doesn't fail a benchmark.
+/// @param name The benchmark name.
+/// @param iterations Times to run the operation in each run.
+/// @param operation The operation.
+template <typename Operation>
+static void measure(const char* name, uint32_t iterations, Operation operation)
+{
+    // Warm up caches and any lazily allocated state
+    for (int i = 0; i < 5; i++)
+    {
+        operation();
+    }
+    int64_t fastest = INT64_MAX;
+    uint32_t allocated = 0;
+    for (int run = 0; run < 5; run++)
+    {
+        uint32_t startAllocations = Benchmark::allocations.load(std::memory_order_relaxed);
+        int64_t start = esp_timer_get_time();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            operation();
+        }
+        fastest = min(fastest, esp_timer_get_time() - start);
+        allocated = max(allocated, Benchmark::allocations.load(std::memory_order_relaxed) - startAllocations);
+    }
+    JsonObject result = results_doc["benchmarks"][name].to<JsonObject>();
+    result["iterations"] = iterations;
+    result["nsPerOp"] = fastest * 1000.0f / iterations;
+    result["allocationsPerOp"] = (float)allocated / iterations;
+}
+
+/// @brief Benchmarks the host only paths, which need the web server and UDP stand-ins.
+static void runCommandBenchmarks()
+{
+    // A move from receiving the request to the response, including the form parsing the web server library does
+    measure("httpMove", 2000, []() {
+        {
+            AsyncWebServerRequest request(HTTP_POST, "/move");
+            request.parseForm("move=2&magnitude=1");
+            server.handle(&request);
+            httpCode = request.sentCode;
+        }
+        xQueueReset(commandQueue);
+    });
+    // Only the firmware's part of a move request: reading the parameters, queueing the move and replying
+    AsyncWebServerRequest moveRequest(HTTP_POST, "/move");
+    moveRequest.parseForm("move=2&magnitude=1");
+    AsyncCallbackWebHandler* moveRoute = server.route(HTTP_POST, "/move");
+    measure("moveHandler", 2000, [moveRoute, &moveRequest]() {
+        moveRoute->onRequest(&moveRequest);
+        xQueueReset(commandQueue);
+    });
+    handlerCodes[0] = moveRequest.sentCode;
+    AsyncWebServerRequest assignRequest(HTTP_PUT, "/assignPlayer");
+    assignRequest.parseForm("player=3&botNumber=1");
+    AsyncCallbackWebHandler* assignRoute = server.route(HTTP_PUT, "/assignPlayer");
+    measure("assignPlayerHandler", 2000, [assignRoute, &assignRequest]() {
+        assignRoute->onRequest(&assignRequest);
+        xQueueReset(commandQueue);
+    });
+    handlerCodes[1] = assignRequest.sentCode;
+    // The same move as a binary command packet, from receiving the datagram to the acknowledgement
+    static uint16_t sequence = 0;
+    measure("udpMove", 2000, []() {
+        sequence++;
+        uint8_t data[9] = { BinaryCommandChannel::Magic, BinaryCommandChannel::Move, 1, (uint8_t)sequence, (uint8_t)(sequence >> 8), 2, 0, 1, 0 };
+        AsyncUDPPacket packet(data, sizeof(data), IPAddress(192, 168, 1, 2), 9000);
+        stub::deliver(BinaryCommandChannel::Port, packet);
+        udpStatus = packet.replyLength == 5 ? packet.reply[1] : -1;
+        xQueueReset(commandQueue);
+    });
+}
+
+/// @brief Every benchmark in the suite runs and has a baseline to compare against.
+void test_suite_runs()
+{
+    benchmark.run();
+    TEST_ASSERT_TRUE(benchmark.hasResults());
+    TEST_ASSERT_FALSE(deserializeJson(results_doc, benchmark.getResults()));
+    runCommandBenchmarks();
+    int count = 0;
+    for (JsonPair result : results_doc["benchmarks"].as<JsonObject>())
+    {
+        char message[160];
+        snprintf(message, sizeof(message), "%s has no baseline, add one to baseline.h", result.key().c_str());
+        TEST_ASSERT_TRUE_MESSAGE(findBaseline(result.key().c_str()) != NULL, message);
+        count++;
+    }
+    TEST_ASSERT_EQUAL(sizeof(Baselines) / sizeof(Baseline), count);
+}
+
+/// @brief No benchmark is slower than its baseline allows.
+void test_time_within_baseline()
+{
+    bool passed = true;
+    for (JsonPair result : results_doc["benchmarks"].as<JsonObject>())
+    {
+        const Baseline* baseline = findBaseline(result.key().c_str());
+        if (baseline == NULL || !recorded(baseline))
+        {
+            // Reported by test_suite_runs and test_print_baseline
+            continue;
+        }
+        float nanoseconds = result.value()["nsPerOp"];
+        float limit = baseline->nanoseconds * (1 + TimeTolerance) + TimeSlack;
+        char message[200];
+        snprintf(message, sizeof(message), "%s: %.0fns/op, baseline %.0fns/op, limit %.0fns/op%s", baseline->name,
+            nanoseconds, baseline->nanoseconds, limit, nanoseconds > limit ? " SLOWER" : "");
+        TEST_MESSAGE(message);
+        passed &= nanoseconds <= limit;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(passed, "A hot path slowed down beyond its baseline tolerance");
+}
+
+/// @brief No benchmark allocates more than its baseline allows.
+void test_allocations_within_baseline()
+{
+    if (!CountingAllocations)
+    {
+        TEST_IGNORE_MESSAGE("Allocations are only counted with glibc");
+    }
+    bool passed = true;
+    for (JsonPair result : results_doc["benchmarks"].as<JsonObject>())
+    {
+        const Baseline* baseline = findBaseline(result.key().c_str());
+        if (baseline == NULL || !recorded(baseline))
+        {
+            // Reported by test_suite_runs and test_print_baseline
+            continue;
+        }
+        float allocations = result.value()["allocationsPerOp"];
+        float limit = baseline->allocations * (1 + AllocationTolerance) + 0.5f;
+        char message[200];
+        snprintf(message, sizeof(message), "%s: %.2f allocations/op, baseline %.2f, limit %.2f%s", baseline->name,
+            allocations, baseline->allocations, limit, allocations > limit ? " MORE" : "");
+        TEST_MESSAGE(message);
+        passed &= allocations <= limit;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(passed, "A hot path allocates more than its baseline allows");
+}
+
+/// @brief A move over the binary command channel is accepted faster than over HTTP, without allocating.
+void test_udp_faster_than_http()
+{
+    TEST_ASSERT_EQUAL(HTTP_CODE_ACCEPTED, httpCode);
+    TEST_ASSERT_EQUAL(BinaryCommandChannel::Accepted, udpStatus);
+    float http = results_doc["benchmarks"]["httpMove"]["nsPerOp"];
+    float udp = results_doc["benchmarks"]["udpMove"]["nsPerOp"];
+    char message[120];
+    snprintf(message, sizeof(message), "Move over HTTP %.0fns, over UDP %.0fns, %.1f times faster", http, udp, http / udp);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN_FLOAT(http, udp);
+    if (CountingAllocations)
+    {
+        TEST_ASSERT_EQUAL_FLOAT(0, results_doc["benchmarks"]["udpMove"]["allocationsPerOp"].as<float>());
+    }
+}
+
+/// @brief The /move and /assignPlayer handlers read their parameters and queue the command without allocating.
+void test_handlers_allocation_free()
+{
+    TEST_ASSERT_EQUAL(HTTP_CODE_ACCEPTED, handlerCodes[0]);
+    TEST_ASSERT_EQUAL(HTTP_CODE_ACCEPTED, handlerCodes[1]);
+    if (!CountingAllocations)
+    {
+        TEST_IGNORE_MESSAGE("Allocations are only counted with glibc");
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0, results_doc["benchmarks"]["moveHandler"]["allocationsPerOp"].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(0, results_doc["benchmarks"]["assignPlayerHandler"]["allocationsPerOp"].as<float>());
+}
+
+/// @brief Prints the results as baseline.h entries, for re-recording the baseline after a deliberate change.
+void test_print_baseline()
+{
+    for (JsonPair result : results_doc["benchmarks"].as<JsonObject>())
+    {
+        const Baseline* baseline = findBaseline(result.key().c_str());
+        char line[120];
+        snprintf(line, sizeof(line), "{ \"%s\", %.0f, %.2f },%s", result.key().c_str(),
+            result.value()["nsPerOp"].as<float>(), result.value()["allocationsPerOp"].as<float>(),
+            baseline != NULL && !recorded(baseline) ? " // not recorded yet, unchecked" : "");
+        TEST_MESSAGE(line);
+    }
+}
+
+int main()
+{
+    robot.begin();
+    webserver.ServerStart();
+    channel.begin();
+    UNITY_BEGIN();
+    RUN_TEST(test_suite_runs);
+    RUN_TEST(test_time_within_baseline);
+    RUN_TEST(test_allocations_within_baseline);
+    RUN_TEST(test_udp_faster_than_http);
+    RUN_TEST(test_handlers_allocation_free);
+    RUN_TEST(test_print_baseline);
+    return UNITY_END();
+}
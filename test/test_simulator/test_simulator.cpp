@@ -0,0 +1,94 @@
+/*
+ * This file is licensed under the MIT Lesser General Public License Copyright (c) 2023 RoboRuckus Group
+ *
+ * Replays moves through the real motion code against the Simulator's plant model on the host,
+ * failing if any scenario misses its heading, deviation, time or jitter limits. Run with: pio test -e native -f test_simulator
+ *
+ * Contributors: Sam Groveman
+ */
+
+#include <unity.h>
+#include <RuckusBot.h>
+#include <Simulator.h>
+
+Configuration config;
+HTTPCommunication communicator(&config);
+FlightRecorder recorder;
+Telemetry telemetry(&recorder);
+Battery battery(&config, &telemetry);
+RuckusBot robot(&config, &communicator, &telemetry, &battery);
+Simulator simulator(&config, &recorder);
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief Prints the results of the last run, one scenario per line.
+/// @param results_doc The parsed results.
+static void printResults(JsonDocument& results_doc)
+{
+    for (JsonObject result : results_doc["scenarios"].as<JsonArray>())
+    {
+        char line[200];
+        snprintf(line, sizeof(line), "%s: heading error %.1f degrees, deviation %.0fmm, %ums, jitter %.1fus %s",
+            result["name"].as<const char*>(), result["headingError"].as<float>(), result["deviation"].as<float>(),
+            result["time"].as<unsigned int>(), result["jitter"].as<float>(), result["passed"] ? "passed" : "FAILED");
+        TEST_MESSAGE(line);
+    }
+}
+
+/// @brief Every built in scenario is within its limits with the default settings.
+void test_default_scenarios_pass()
+{
+    bool passed = simulator.run(&robot, "");
+    JsonDocument results_doc;
+    TEST_ASSERT_FALSE(deserializeJson(results_doc, simulator.getResults()));
+    printResults(results_doc);
+    TEST_ASSERT_EQUAL(6, results_doc["scenarios"].size());
+    TEST_ASSERT_TRUE_MESSAGE(passed, "A replay scenario missed its limits");
+    TEST_ASSERT_TRUE(results_doc["passed"]);
+}
+
+/// @brief Turns finish at their target heading and drives keep it.
+void test_scenarios_reach_target()
+{
+    simulator.run(&robot, "[{\"name\": \"right\", \"move\": 1}, {\"name\": \"left\", \"move\": 0}, {\"name\": \"forward\", \"move\": 2}]");
+    JsonDocument results_doc;
+    TEST_ASSERT_FALSE(deserializeJson(results_doc, simulator.getResults()));
+    printResults(results_doc);
+    for (JsonObject result : results_doc["scenarios"].as<JsonArray>())
+    {
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5, 0, result["headingError"].as<float>(), result["name"].as<const char*>());
+        TEST_ASSERT_TRUE_MESSAGE(result["commands"].as<int>() >= 2, result["name"].as<const char*>());
+    }
+}
+
+/// @brief A scenario fails once a measurement is outside a limit it sets.
+void test_limits_fail_scenario()
+{
+    bool passed = simulator.run(&robot, "[{\"name\": \"tight\", \"move\": 2, \"mismatch\": 0.2, \"maxHeadingError\": 0.01, \"maxDeviation\": 0.01}]");
+    JsonDocument results_doc;
+    TEST_ASSERT_FALSE(deserializeJson(results_doc, simulator.getResults()));
+    printResults(results_doc);
+    TEST_ASSERT_FALSE(passed);
+    TEST_ASSERT_FALSE(results_doc["scenarios"][0]["passed"]);
+}
+
+/// @brief Scenarios that aren't an array, or have no valid moves, are refused.
+void test_bad_scenarios_refused()
+{
+    TEST_ASSERT_FALSE(simulator.run(&robot, "{\"move\": 2}"));
+    TEST_ASSERT_FALSE(simulator.run(&robot, "[{\"move\": 5}]"));
+    TEST_ASSERT_FALSE(simulator.passed());
+}
+
+int main()
+{
+    robot.begin();
+    UNITY_BEGIN();
+    RUN_TEST(test_default_scenarios_pass);
+    RUN_TEST(test_scenarios_reach_target);
+    RUN_TEST(test_limits_fail_scenario);
+    RUN_TEST(test_bad_scenarios_refused);
+    return UNITY_END();
+}